@@ -0,0 +1,369 @@
+#include "Importer.h"
+#include "Json.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace
+{
+    const uint32_t glbMagic{ 0x46546C67 };      // "glTF"
+    const uint32_t glbJsonChunk{ 0x4E4F534A };  // "JSON"
+    const uint32_t glbBinaryChunk{ 0x004E4942 };// "BIN\0"
+
+    const int componentByte{ 5120 }, componentUnsignedByte{ 5121 }, componentShort{ 5122 }, componentUnsignedShort{ 5123 };
+    const int componentUnsignedInt{ 5125 }, componentFloat{ 5126 };
+    const int modeTriangles{ 4 };
+
+    bool readFile(const std::string& path, std::vector<char>& out)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+            return false;
+        out.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        return true;
+    }
+
+    bool decodeBase64(const std::string& text, size_t start, std::vector<char>& out)
+    {
+        auto digit = [](char c) -> int
+        {
+            if (c >= 'A' && c <= 'Z') return c - 'A';
+            if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+            if (c >= '0' && c <= '9') return c - '0' + 52;
+            if (c == '+') return 62;
+            if (c == '/') return 63;
+            return -1;
+        };
+        uint32_t bits{};
+        int count{};
+        for (size_t i = start; i < text.size() && text[i] != '='; i++)
+        {
+            int value{ digit(text[i]) };
+            if (value < 0)
+                return false;
+            bits = (bits << 6) | uint32_t(value);
+            if (++count == 4)
+            {
+                out.push_back(char(bits >> 16));
+                out.push_back(char(bits >> 8));
+                out.push_back(char(bits));
+                bits = 0;
+                count = 0;
+            }
+        }
+        if (count == 3)
+        {
+            out.push_back(char(bits >> 10));
+            out.push_back(char(bits >> 2));
+        }
+        else if (count == 2)
+        {
+            out.push_back(char(bits >> 4));
+        }
+        return true;
+    }
+
+    class GltfReader
+    {
+    public:
+        bool load(const std::string& path, std::string& error)
+        {
+            std::vector<char> file{};
+            if (!readFile(path, file))
+                return fail(error, "can't open " + path);
+            std::string directory{ path.substr(0, path.find_last_of("/\\") + 1) };
+
+            const char* json{ file.data() };
+            size_t jsonSize{ file.size() };
+            std::vector<char> embedded{};
+            uint32_t header[3]{};
+            if (file.size() >= sizeof(header))
+                memcpy(header, file.data(), sizeof(header));
+            if (header[0] == glbMagic)
+            {
+                // Chunks: {length, type, data} padded to 4 bytes, JSON first
+                size_t at{ sizeof(header) };
+                jsonSize = 0;
+                while (at + 8 <= file.size())
+                {
+                    uint32_t chunk[2]{};
+                    memcpy(chunk, file.data() + at, sizeof(chunk));
+                    at += sizeof(chunk);
+                    if (at + chunk[0] > file.size())
+                        return fail(error, "truncated glb chunk");
+                    if (chunk[1] == glbJsonChunk && !jsonSize)
+                    {
+                        json = file.data() + at;
+                        jsonSize = chunk[0];
+                    }
+                    else if (chunk[1] == glbBinaryChunk && embedded.empty())
+                    {
+                        embedded.assign(file.data() + at, file.data() + at + chunk[0]);
+                    }
+                    at += (chunk[0] + 3) & ~3u;
+                }
+            }
+
+            std::string jsonError{};
+            if (!JsonValue::parse(json, jsonSize, root, jsonError))
+                return fail(error, "bad glTF JSON: " + jsonError);
+
+            const JsonValue& bufferList{ root["buffers"] };
+            for (size_t i = 0; i < bufferList.size(); i++)
+            {
+                buffers.emplace_back();
+                const std::string& uri{ bufferList[i]["uri"].string() };
+                if (uri.empty())
+                    buffers.back() = i == 0 ? embedded : std::vector<char>{};
+                else if (uri.compare(0, 5, "data:") == 0)
+                {
+                    size_t comma{ uri.find(";base64,") };
+                    if (comma == std::string::npos || !decodeBase64(uri, comma + 8, buffers.back()))
+                        return fail(error, "unsupported data uri in buffer " + std::to_string(i));
+                }
+                else if (!readFile(directory + uri, buffers.back()))
+                    return fail(error, "can't open buffer " + directory + uri);
+            }
+            return true;
+        }
+
+        // Default scene, or every root node of every scene's first entry if none is marked
+        bool collect(ImportedMesh& out, std::string& error)
+        {
+            const JsonValue& scenes{ root["scenes"] };
+            if (scenes.size())
+            {
+                const JsonValue& nodes{ scenes[size_t(root["scene"].integer(0))]["nodes"] };
+                for (size_t i = 0; i < nodes.size(); i++)
+                    if (!visit(nodes[i].integer(-1), glm::mat4(1.0f), 0, out, error))
+                        return false;
+            }
+            else
+            {
+                for (size_t i = 0; i < root["meshes"].size(); i++)
+                    if (!addMesh(root["meshes"][i], glm::mat4(1.0f), out, error))
+                        return false;
+            }
+            return true;
+        }
+
+    private:
+        static bool fail(std::string& error, const std::string& message)
+        {
+            error = message;
+            return false;
+        }
+
+        bool visit(int nodeIndex, const glm::mat4& parent, int depth, ImportedMesh& out, std::string& error)
+        {
+            const JsonValue& node{ root["nodes"][size_t(nodeIndex)] };
+            if (nodeIndex < 0 || node.isNull() || depth > 64)
+                return fail(error, "bad node reference");
+
+            glm::mat4 local{ 1.0f };
+            const JsonValue& matrix{ node["matrix"] };
+            if (matrix.size() == 16)
+            {
+                for (int i = 0; i < 16; i++)
+                    glm::value_ptr(local)[i] = float(matrix[size_t(i)].number()); // column-major, like glm
+            }
+            else
+            {
+                const JsonValue& t{ node["translation"] };
+                const JsonValue& r{ node["rotation"] };
+                const JsonValue& s{ node["scale"] };
+                if (t.size() == 3)
+                    local = glm::translate(local, glm::vec3(t[0].number(), t[1].number(), t[2].number()));
+                if (r.size() == 4)
+                    local *= glm::mat4_cast(glm::quat(float(r[3].number()), float(r[0].number()), float(r[1].number()), float(r[2].number())));
+                if (s.size() == 3)
+                    local = glm::scale(local, glm::vec3(s[0].number(), s[1].number(), s[2].number()));
+            }
+            glm::mat4 world{ parent * local };
+
+            if (node.has("mesh") && !addMesh(root["meshes"][size_t(node["mesh"].integer())], world, out, error))
+                return false;
+            const JsonValue& children{ node["children"] };
+            for (size_t i = 0; i < children.size(); i++)
+                if (!visit(children[i].integer(-1), world, depth + 1, out, error))
+                    return false;
+            return true;
+        }
+
+        // Reads `components` values per element; normalized integers are mapped to [0, 1],
+        // signed ones to [-1, 1] with the most negative value clamped like GL does
+        template <typename T>
+        bool readAccessor(int index, int components, std::vector<T>& out, std::string& error) const
+        {
+            const JsonValue& accessor{ root["accessors"][size_t(index)] };
+            if (accessor.has("sparse"))
+                return fail(error, "accessor " + std::to_string(index) + " is sparse, which is not supported");
+            const JsonValue& view{ root["bufferViews"][size_t(accessor["bufferView"].integer(-1))] };
+            if (accessor.isNull() || view.isNull())
+                return fail(error, "accessor " + std::to_string(index) + " has no buffer view");
+
+            int type{ accessor["componentType"].integer() };
+            size_t componentSize{};
+            if (type == componentFloat || type == componentUnsignedInt)
+                componentSize = 4;
+            else if (type == componentShort || type == componentUnsignedShort)
+                componentSize = 2;
+            else if (type == componentByte || type == componentUnsignedByte)
+                componentSize = 1;
+            else
+                return fail(error, "accessor " + std::to_string(index) + " has unknown component type " + std::to_string(type));
+            size_t count{ size_t(accessor["count"].integer()) };
+            size_t stride{ size_t(view["byteStride"].integer(0)) };
+            if (!stride)
+                stride = componentSize * components;
+            size_t offset{ size_t(view["byteOffset"].integer(0)) + size_t(accessor["byteOffset"].integer(0)) };
+            size_t bufferIndex{ size_t(view["buffer"].integer(-1)) };
+            if (bufferIndex >= buffers.size() || (count && offset + (count - 1) * stride + componentSize * components > buffers[bufferIndex].size()))
+                return fail(error, "accessor " + std::to_string(index) + " is outside its buffer");
+
+            bool normalized{ accessor["normalized"].boolean() };
+            const char* data{ buffers[bufferIndex].data() + offset };
+            out.resize(count * components);
+            for (size_t i = 0; i < count; i++)
+            {
+                for (int c = 0; c < components; c++)
+                {
+                    const char* element{ data + i * stride + c * componentSize };
+                    double value{};
+                    if (type == componentFloat)
+                    {
+                        float raw{};
+                        memcpy(&raw, element, 4);
+                        value = raw;
+                    }
+                    else if (type == componentUnsignedInt)
+                    {
+                        uint32_t raw{};
+                        memcpy(&raw, element, 4);
+                        value = raw;
+                    }
+                    else if (type == componentShort)
+                    {
+                        int16_t raw{};
+                        memcpy(&raw, element, 2);
+                        value = normalized ? std::max(raw / 32767.0, -1.0) : raw;
+                    }
+                    else if (type == componentUnsignedShort)
+                    {
+                        uint16_t raw{};
+                        memcpy(&raw, element, 2);
+                        value = normalized ? raw / 65535.0 : raw;
+                    }
+                    else if (type == componentByte)
+                    {
+                        int8_t raw{ int8_t(*element) };
+                        value = normalized ? std::max(raw / 127.0, -1.0) : raw;
+                    }
+                    else
+                    {
+                        uint8_t raw{ uint8_t(*element) };
+                        value = normalized ? raw / 255.0 : raw;
+                    }
+                    out[i * components + c] = static_cast<T>(value);
+                }
+            }
+            return true;
+        }
+
+        bool addMesh(const JsonValue& mesh, const glm::mat4& world, ImportedMesh& out, std::string& error)
+        {
+            glm::mat3 normalMatrix{ glm::transpose(glm::inverse(glm::mat3(world))) };
+            // A mirroring transform turns counter-clockwise triangles clockwise, swap two corners back
+            bool mirrored{ glm::determinant(glm::mat3(world)) < 0.0f };
+            const size_t corners[2][3]{ { 0, 1, 2 }, { 0, 2, 1 } };
+            const JsonValue& primitives{ mesh["primitives"] };
+            for (size_t p = 0; p < primitives.size(); p++)
+            {
+                const JsonValue& primitive{ primitives[p] };
+                if (primitive["mode"].integer(modeTriangles) != modeTriangles)
+                {
+                    fprintf(stderr, "warning: skipping a non-triangle primitive\n");
+                    continue;
+                }
+
+                const JsonValue& attributes{ primitive["attributes"] };
+                std::vector<float> positions{}, normals{}, texcoords{};
+                std::vector<uint32_t> indices{};
+                if (!readAccessor(attributes["POSITION"].integer(-1), 3, positions, error))
+                    return false;
+                if (attributes.has("NORMAL") && !readAccessor(attributes["NORMAL"].integer(), 3, normals, error))
+                    return false;
+                if (attributes.has("TEXCOORD_0") && !readAccessor(attributes["TEXCOORD_0"].integer(), 2, texcoords, error))
+                    return false;
+                if (primitive.has("indices") && !readAccessor(primitive["indices"].integer(), 1, indices, error))
+                    return false;
+
+                size_t vertexCount{ positions.size() / 3 };
+                size_t cornerCount{ indices.empty() ? vertexCount : indices.size() };
+                // Streams of every primitive must line up with the positions in the soup
+                bool withNormals{ !normals.empty() || !out.normals.empty() };
+                bool withTexcoords{ !texcoords.empty() || !out.texcoords.empty() };
+                if (withNormals)
+                    out.normals.resize(out.positions.size(), 0.0f);
+                if (withTexcoords)
+                    out.texcoords.resize(out.positions.size() / 3 * 2, 0.0f);
+
+                for (size_t i = 0; i + 2 < cornerCount; i += 3)
+                {
+                    for (size_t k = 0; k < 3; k++)
+                    {
+                        size_t corner{ i + corners[mirrored][k] };
+                        size_t vertex{ indices.empty() ? corner : indices[corner] };
+                        if (vertex >= vertexCount)
+                            return fail(error, "index out of range");
+                        glm::vec3 position{ world * glm::vec4(positions[vertex * 3], positions[vertex * 3 + 1], positions[vertex * 3 + 2], 1.0f) };
+                        out.positions.insert(out.positions.end(), { position.x, position.y, position.z });
+                        if (withNormals)
+                        {
+                            glm::vec3 normal{ 0.0f };
+                            if (!normals.empty())
+                                normal = normalMatrix * glm::vec3(normals[vertex * 3], normals[vertex * 3 + 1], normals[vertex * 3 + 2]);
+                            float length{ glm::length(normal) };
+                            if (length > 0.0f)
+                                normal /= length;
+                            out.normals.insert(out.normals.end(), { normal.x, normal.y, normal.z });
+                        }
+                        if (withTexcoords)
+                        {
+                            float u{ texcoords.empty() ? 0.0f : texcoords[vertex * 2] };
+                            float v{ texcoords.empty() ? 0.0f : texcoords[vertex * 2 + 1] };
+                            out.texcoords.insert(out.texcoords.end(), { u, v });
+                        }
+                    }
+                }
+            }
+            return true;
+        }
+
+        JsonValue                       root{};
+        std::vector<std::vector<char>>  buffers{};
+    };
+}
+
+bool importGltf(const std::string& path, ImportedMesh& out, std::string& error)
+{
+    out = ImportedMesh{};
+    GltfReader reader{};
+    if (!reader.load(path, error) || !reader.collect(out, error))
+        return false;
+    if (out.positions.empty())
+    {
+        error = "no triangles";
+        return false;
+    }
+    return true;
+}
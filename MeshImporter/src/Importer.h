@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "MeshBuilder.h"
+#include "VertexFormat.h"
+
+// What every parser produces: a triangle soup, 3 corners per triangle, one entry per
+// corner in each stream. Missing normals or texcoords are left empty.
+struct ImportedMesh
+{
+    std::vector<float> positions{};     // xyz
+    std::vector<float> normals{};       // xyz
+    std::vector<float> texcoords{};     // uv
+
+    size_t cornerCount() const { return positions.size() / 3; }
+};
+
+// OBJ text, cut into newline-aligned chunks parsed on `threads` threads. Only v/vt/vn/f
+// are read, polygons are fanned into triangles, negative indices are supported.
+bool parseObj(const char* text, size_t size, unsigned threads, ImportedMesh& out, std::string& error);
+
+// .gltf with embedded, data: or external buffers, or .glb. Triangle primitives of the
+// default scene with their node transforms; the other primitive modes are skipped.
+bool importGltf(const std::string& path, ImportedMesh& out, std::string& error);
+
+// Welds the soup into importedStreams() float vertices, generating smooth
+// normals when there are none and per-vertex tangents from the texcoords
+Mesh buildMesh(const ImportedMesh& soup);
+
+// position 3, normal 3, tangent 4 (w = handedness), texcoord 2 floats
+const int importedStride{ 12 };
+const VertexStreams importedStreams{ 0, 3, 6, 10 };
+
+// Fast path for OBJ numbers: no locale, no errno, digits + optional fraction and exponent
+const char* parseFloat(const char* at, const char* end, float& out);
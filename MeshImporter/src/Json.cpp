@@ -0,0 +1,231 @@
+#include "Json.h"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+    const JsonValue nullValue{};
+}
+
+class JsonReader
+{
+public:
+    JsonReader(const char* text, size_t size) : at(text), begin(text), end(text + size) {}
+
+    bool read(JsonValue& out, std::string& error)
+    {
+        if (!value(out, 0))
+        {
+            error = message + " at byte " + std::to_string(at - begin);
+            return false;
+        }
+        skipSpace();
+        return true;
+    }
+
+private:
+    bool fail(const char* what)
+    {
+        if (message.empty())
+            message = what;
+        return false;
+    }
+
+    void skipSpace()
+    {
+        while (at < end && (*at == ' ' || *at == '\t' || *at == '\n' || *at == '\r'))
+            at++;
+    }
+
+    bool literal(const char* word)
+    {
+        size_t length{ strlen(word) };
+        if (size_t(end - at) < length || memcmp(at, word, length) != 0)
+            return fail("unknown literal");
+        at += length;
+        return true;
+    }
+
+    bool string(std::string& out)
+    {
+        at++; // opening quote
+        while (at < end && *at != '"')
+        {
+            char c{ *at++ };
+            if (c != '\\')
+            {
+                out += c;
+                continue;
+            }
+            if (at == end)
+                break;
+            char escape{ *at++ };
+            switch (escape)
+            {
+            case 'b': out += '\b'; break;
+            case 'f': out += '\f'; break;
+            case 'n': out += '\n'; break;
+            case 'r': out += '\r'; break;
+            case 't': out += '\t'; break;
+            case 'u':
+            {
+                // Basic multilingual plane only, as UTF-8; glTF names and URIs rarely need more
+                if (end - at < 4)
+                    return fail("short \\u escape");
+                unsigned code{ static_cast<unsigned>(strtoul(std::string(at, at + 4).c_str(), nullptr, 16)) };
+                at += 4;
+                if (code < 0x80)
+                    out += static_cast<char>(code);
+                else if (code < 0x800)
+                {
+                    out += static_cast<char>(0xC0 | (code >> 6));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                }
+                else
+                {
+                    out += static_cast<char>(0xE0 | (code >> 12));
+                    out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                    out += static_cast<char>(0x80 | (code & 0x3F));
+                }
+                break;
+            }
+            default: out += escape; break;
+            }
+        }
+        if (at == end)
+            return fail("unterminated string");
+        at++;
+        return true;
+    }
+
+    bool value(JsonValue& out, int depth)
+    {
+        if (depth > 256)
+            return fail("nesting too deep");
+        skipSpace();
+        if (at == end)
+            return fail("unexpected end");
+
+        switch (*at)
+        {
+        case '{':
+        {
+            out.kind = JsonValue::Type::Object;
+            at++;
+            skipSpace();
+            if (at < end && *at == '}')
+            {
+                at++;
+                return true;
+            }
+            while (true)
+            {
+                skipSpace();
+                if (at == end || *at != '"')
+                    return fail("expected a key");
+                out.keys.emplace_back();
+                if (!string(out.keys.back()))
+                    return false;
+                skipSpace();
+                if (at == end || *at++ != ':')
+                    return fail("expected ':'");
+                out.items.emplace_back();
+                if (!value(out.items.back(), depth + 1))
+                    return false;
+                skipSpace();
+                if (at < end && *at == ',')
+                {
+                    at++;
+                    continue;
+                }
+                if (at < end && *at == '}')
+                {
+                    at++;
+                    return true;
+                }
+                return fail("expected ',' or '}'");
+            }
+        }
+        case '[':
+        {
+            out.kind = JsonValue::Type::Array;
+            at++;
+            skipSpace();
+            if (at < end && *at == ']')
+            {
+                at++;
+                return true;
+            }
+            while (true)
+            {
+                out.items.emplace_back();
+                if (!value(out.items.back(), depth + 1))
+                    return false;
+                skipSpace();
+                if (at < end && *at == ',')
+                {
+                    at++;
+                    continue;
+                }
+                if (at < end && *at == ']')
+                {
+                    at++;
+                    return true;
+                }
+                return fail("expected ',' or ']'");
+            }
+        }
+        case '"':
+            out.kind = JsonValue::Type::String;
+            return string(out.text);
+        case 't':
+            out.kind = JsonValue::Type::Bool;
+            out.value = 1.0;
+            return literal("true");
+        case 'f':
+            out.kind = JsonValue::Type::Bool;
+            return literal("false");
+        case 'n':
+            return literal("null");
+        default:
+        {
+            // strtod needs a terminator, numbers are short
+            const char* start{ at };
+            while (at < end && strchr("+-0123456789.eE", *at))
+                at++;
+            if (at == start)
+                return fail("unexpected character");
+            out.kind = JsonValue::Type::Number;
+            out.value = strtod(std::string(start, at).c_str(), nullptr);
+            return true;
+        }
+        }
+    }
+
+    const char* at;
+    const char* begin;
+    const char* end;
+    std::string message{};
+};
+
+bool JsonValue::parse(const char* text, size_t size, JsonValue& out, std::string& error)
+{
+    out = JsonValue{};
+    return JsonReader(text, size).read(out, error);
+}
+
+const JsonValue& JsonValue::operator[](size_t index) const
+{
+    return kind == Type::Array && index < items.size() ? items[index] : nullValue;
+}
+
+const JsonValue& JsonValue::operator[](const char* key) const
+{
+    if (kind != Type::Object)
+        return nullValue;
+    for (size_t i = 0; i < keys.size(); i++)
+        if (keys[i] == key)
+            return items[i];
+    return nullValue;
+}
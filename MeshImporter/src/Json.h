@@ -0,0 +1,39 @@
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+// Just enough JSON for glTF: a DOM of values, lookups return a shared null value when
+// something is missing so accessor chains don't need checks at every step.
+class JsonValue
+{
+public:
+    enum class Type { Null, Bool, Number, String, Array, Object };
+
+    // False on malformed text, error gets a message with the byte offset
+    static bool parse(const char* text, size_t size, JsonValue& out, std::string& error);
+
+    Type type() const { return kind; }
+    bool isNull() const { return kind == Type::Null; }
+
+    double number(double fallback = 0.0) const { return kind == Type::Number ? value : fallback; }
+    int integer(int fallback = 0) const { return kind == Type::Number ? static_cast<int>(value) : fallback; }
+    bool boolean(bool fallback = false) const { return kind == Type::Bool ? value != 0.0 : fallback; }
+    const std::string& string() const { return text; }
+
+    size_t size() const { return items.size(); }            // array items or object members
+    const JsonValue& operator[](size_t index) const;
+    const JsonValue& operator[](int index) const { return (*this)[static_cast<size_t>(index)]; } // -1 gives null
+    const JsonValue& operator[](const char* key) const;
+    bool has(const char* key) const { return !(*this)[key].isNull(); }
+
+private:
+    friend class JsonReader;
+
+    Type                                        kind{ Type::Null };
+    double                                      value{};
+    std::string                                 text{};
+    std::vector<JsonValue>                      items{};
+    std::vector<std::string>                    keys{};     // parallel to items for objects
+};
@@ -0,0 +1,319 @@
+// Offline asset path: OBJ / glTF 2.0 in, the sandbox's mapped mesh format out.
+// Meshes are welded, given normals and tangents where missing, cache/overdraw/fetch
+// optimized, split into meshlets for cluster culling, simplified into a LOD chain (--lods N,
+// 0 for none) and quantized (--float keeps 32-bit floats), so OpenGL-Sandbox --mesh <file.mesh> only has to map and upload them.
+//
+// Usage: MeshImporter <input.obj|.gltf|.glb> [-o <output.mesh>] [--threads N] [--float] [--lods N]
+//        MeshImporter --benchmark [megabytes]    OBJ parse throughput on a generated grid
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Importer.h"
+#include "MappedFile.h"
+#include "MeshFile.h"
+#include "MeshOptimizer.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    double millisecondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    glm::vec3 readVec3(const std::vector<float>& data, size_t index, int stride, int offset)
+    {
+        const float* v{ &data[index * stride + offset] };
+        return glm::vec3(v[0], v[1], v[2]);
+    }
+
+    // Vertices without a normal get the area weighted average over every vertex at that position
+    void generateNormals(Mesh& mesh)
+    {
+        const int normalOffset{ 3 };
+        MeshBuilder positions{ 3 };
+        std::vector<uint32_t> group(mesh.vertexCount());
+        for (size_t v = 0; v < mesh.vertexCount(); v++)
+            group[v] = positions.addVertex(&mesh.vertices[v * mesh.stride]);
+
+        std::vector<glm::vec3> accumulated(positions.mesh().vertexCount(), glm::vec3(0.0f));
+        for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+        {
+            glm::vec3 a{ readVec3(mesh.vertices, mesh.indices[i], mesh.stride, 0) };
+            glm::vec3 b{ readVec3(mesh.vertices, mesh.indices[i + 1], mesh.stride, 0) };
+            glm::vec3 c{ readVec3(mesh.vertices, mesh.indices[i + 2], mesh.stride, 0) };
+            glm::vec3 normal{ glm::cross(b - a, c - a) }; // length is twice the area
+            for (int k = 0; k < 3; k++)
+                accumulated[group[mesh.indices[i + k]]] += normal;
+        }
+
+        for (size_t v = 0; v < mesh.vertexCount(); v++)
+        {
+            float* normal{ &mesh.vertices[v * mesh.stride + normalOffset] };
+            if (normal[0] != 0.0f || normal[1] != 0.0f || normal[2] != 0.0f)
+                continue;
+            glm::vec3 smooth{ accumulated[group[v]] };
+            float length{ glm::length(smooth) };
+            smooth = length > 0.0f ? smooth / length : glm::vec3(0.0f, 0.0f, 1.0f);
+            normal[0] = smooth.x;
+            normal[1] = smooth.y;
+            normal[2] = smooth.z;
+        }
+    }
+
+    // Lengyel's method: per-triangle texture space directions summed per vertex, then
+    // Gram-Schmidt against the normal; w keeps the bitangent's handedness
+    void generateTangents(Mesh& mesh)
+    {
+        const int normalOffset{ 3 }, tangentOffset{ 6 }, texcoordOffset{ 10 };
+        std::vector<glm::vec3> sDirection(mesh.vertexCount(), glm::vec3(0.0f)), tDirection(mesh.vertexCount(), glm::vec3(0.0f));
+        for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+        {
+            uint32_t corner[3]{ mesh.indices[i], mesh.indices[i + 1], mesh.indices[i + 2] };
+            glm::vec3 p[3];
+            glm::vec2 uv[3];
+            for (int k = 0; k < 3; k++)
+            {
+                p[k] = readVec3(mesh.vertices, corner[k], mesh.stride, 0);
+                uv[k] = glm::vec2(mesh.vertices[corner[k] * mesh.stride + texcoordOffset],
+                                  mesh.vertices[corner[k] * mesh.stride + texcoordOffset + 1]);
+            }
+            glm::vec3 edge1{ p[1] - p[0] }, edge2{ p[2] - p[0] };
+            glm::vec2 duv1{ uv[1] - uv[0] }, duv2{ uv[2] - uv[0] };
+            float determinant{ duv1.x * duv2.y - duv2.x * duv1.y };
+            if (std::abs(determinant) < 1e-12f)
+                continue; // no texture space, the fallback below picks one
+            float r{ 1.0f / determinant };
+            glm::vec3 s{ (edge1 * duv2.y - edge2 * duv1.y) * r };
+            glm::vec3 t{ (edge2 * duv1.x - edge1 * duv2.x) * r };
+            for (int k = 0; k < 3; k++)
+            {
+                sDirection[corner[k]] += s;
+                tDirection[corner[k]] += t;
+            }
+        }
+
+        for (size_t v = 0; v < mesh.vertexCount(); v++)
+        {
+            glm::vec3 n{ readVec3(mesh.vertices, v, mesh.stride, normalOffset) };
+            glm::vec3 tangent{ sDirection[v] - n * glm::dot(n, sDirection[v]) };
+            float length{ glm::length(tangent) };
+            if (length < 1e-12f)
+            {
+                // Any direction perpendicular to the normal
+                glm::vec3 axis{ std::abs(n.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f) };
+                tangent = glm::normalize(glm::cross(axis, n));
+            }
+            else
+            {
+                tangent /= length;
+            }
+            float handedness{ glm::dot(glm::cross(n, tangent), tDirection[v]) < 0.0f ? -1.0f : 1.0f };
+            float* out{ &mesh.vertices[v * mesh.stride + tangentOffset] };
+            out[0] = tangent.x;
+            out[1] = tangent.y;
+            out[2] = tangent.z;
+            out[3] = handedness;
+        }
+    }
+
+    bool endsWith(const std::string& text, const std::string& suffix)
+    {
+        return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    // Grid with positions, texcoords, normals and quads, roughly `megabytes` of text
+    std::string generateObj(size_t megabytes)
+    {
+        size_t side{ static_cast<size_t>(std::sqrt(megabytes * 1024.0 * 1024.0 / 150.0)) + 2 };
+        std::string text{};
+        text.reserve(megabytes * 1024 * 1024 + 4096);
+        char line[160];
+        for (size_t y = 0; y < side; y++)
+            for (size_t x = 0; x < side; x++)
+            {
+                float u{ float(x) / (side - 1) }, v{ float(y) / (side - 1) };
+                text.append(line, snprintf(line, sizeof(line), "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn 0.000000 0.000000 1.000000\n",
+                                           u * 2.0f - 1.0f, v * 2.0f - 1.0f, 0.25f * std::sin(u * 20.0f), u, v));
+            }
+        for (size_t y = 0; y + 1 < side; y++)
+            for (size_t x = 0; x + 1 < side; x++)
+            {
+                size_t a{ y * side + x + 1 }, b{ a + 1 }, c{ a + side + 1 }, d{ a + side };
+                text.append(line, snprintf(line, sizeof(line), "f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n",
+                                           a, a, a, b, b, b, c, c, c, d, d, d));
+            }
+        return text;
+    }
+
+    int benchmark(size_t megabytes)
+    {
+        std::string text{ generateObj(megabytes) };
+        double size{ text.size() / (1024.0 * 1024.0) };
+        printf("OBJ parse benchmark, %.1f MB generated grid\n", size);
+
+        unsigned hardware{ std::max(1u, std::thread::hardware_concurrency()) };
+        std::vector<unsigned> threadCounts{ 1 };
+        if (hardware > 1)
+            threadCounts.push_back(hardware);
+        for (unsigned threads : threadCounts)
+        {
+            // Best of 3, the first run also pays for page faults in the output
+            double best{ 1e30 };
+            size_t triangles{};
+            for (int run = 0; run < 3; run++)
+            {
+                ImportedMesh soup{};
+                std::string error{};
+                Clock::time_point start{ Clock::now() };
+                if (!parseObj(text.data(), text.size(), threads, soup, error))
+                {
+                    fprintf(stderr, "benchmark parse failed: %s\n", error.c_str());
+                    return 1;
+                }
+                best = std::min(best, millisecondsSince(start));
+                triangles = soup.cornerCount() / 3;
+            }
+            printf("%2u thread(s): %8.1f MB/s  %8.2f ms  %zu triangles\n", threads, size / (best / 1000.0), best, triangles);
+        }
+        return 0;
+    }
+}
+
+Mesh buildMesh(const ImportedMesh& soup)
+{
+    // Position, normal, texcoord: the attributes that decide whether two corners are one vertex
+    const int weldStride{ 8 };
+    size_t cornerCount{ soup.cornerCount() };
+    std::vector<float> corners(cornerCount * weldStride, 0.0f);
+    for (size_t i = 0; i < cornerCount; i++)
+    {
+        float* corner{ &corners[i * weldStride] };
+        std::copy_n(&soup.positions[i * 3], 3, corner);
+        if (!soup.normals.empty())
+            std::copy_n(&soup.normals[i * 3], 3, corner + 3);
+        if (!soup.texcoords.empty())
+            std::copy_n(&soup.texcoords[i * 2], 2, corner + 6);
+    }
+    MeshBuilder welder{ weldStride };
+    welder.addTriangles(corners.data(), cornerCount);
+    Mesh welded{ welder.take() };
+
+    Mesh mesh{};
+    mesh.stride = importedStride;
+    mesh.indices = std::move(welded.indices);
+    mesh.vertices.resize(welded.vertexCount() * importedStride, 0.0f);
+    for (size_t v = 0; v < welded.vertexCount(); v++)
+    {
+        const float* in{ &welded.vertices[v * weldStride] };
+        float* out{ &mesh.vertices[v * importedStride] };
+        std::copy_n(in, 6, out);            // position, normal
+        std::copy_n(in + 6, 2, out + 10);   // texcoord
+    }
+    generateNormals(mesh);
+    generateTangents(mesh);
+    return mesh;
+}
+
+int main(int argc, char** argv)
+{
+    std::string input{}, output{};
+    unsigned threads{ std::max(1u, std::thread::hardware_concurrency()) };
+    VertexEncoding encoding{ VertexEncoding::Quantized };
+    unsigned lodCount{ 5 };
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg{ argv[i] };
+        if (arg == "--benchmark")
+            return benchmark(i + 1 < argc ? static_cast<size_t>(atoi(argv[i + 1])) : 64);
+        else if (arg == "-o" && i + 1 < argc)
+            output = argv[++i];
+        else if (arg == "--float")
+            encoding = VertexEncoding::Float;
+        else if (arg == "--lods" && i + 1 < argc)
+            lodCount = static_cast<unsigned>(std::max(0, atoi(argv[++i])));
+        else if (arg == "--threads" && i + 1 < argc)
+            threads = static_cast<unsigned>(std::max(1, atoi(argv[++i])));
+        else if (input.empty() && arg[0] != '-')
+            input = arg;
+        else
+            fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+    }
+    if (input.empty())
+    {
+        fprintf(stderr, "Usage: MeshImporter <input.obj|.gltf|.glb> [-o <output.mesh>] [--threads N] [--float] [--lods N]\n"
+                        "       MeshImporter --benchmark [megabytes]\n");
+        return 1;
+    }
+    if (output.empty())
+        output = input.substr(0, input.find_last_of('.')) + ".mesh";
+
+    ImportedMesh soup{};
+    std::string error{};
+    size_t inputSize{};
+    Clock::time_point start{ Clock::now() };
+    if (endsWith(input, ".obj"))
+    {
+        MappedFile file{};
+        if (!file.open(input))
+        {
+            fprintf(stderr, "Can't open %s\n", input.c_str());
+            return 1;
+        }
+        inputSize = file.size();
+        if (!parseObj(file.data(), file.size(), threads, soup, error))
+        {
+            fprintf(stderr, "%s: %s\n", input.c_str(), error.c_str());
+            return 1;
+        }
+    }
+    else if (endsWith(input, ".gltf") || endsWith(input, ".glb"))
+    {
+        if (!importGltf(input, soup, error))
+        {
+            fprintf(stderr, "%s: %s\n", input.c_str(), error.c_str());
+            return 1;
+        }
+        std::error_code ignored{};
+        inputSize = static_cast<size_t>(std::filesystem::file_size(input, ignored)); // JSON or .glb, not the external buffers
+    }
+    else
+    {
+        fprintf(stderr, "%s: only .obj, .gltf and .glb are supported\n", input.c_str());
+        return 1;
+    }
+    double parseTime{ millisecondsSince(start) };
+    printf("%s: parsed %.1f MB in %.2f ms (%.1f MB/s), %zu triangles\n", input.c_str(),
+           inputSize / (1024.0 * 1024.0), parseTime, inputSize / (1024.0 * 1024.0) / (parseTime / 1000.0), soup.cornerCount() / 3);
+
+    start = Clock::now();
+    Mesh mesh{ buildMesh(soup) };
+    optimizeMesh(mesh, input.c_str(), stdout);
+    std::vector<Meshlet> meshlets{ buildMeshlets(mesh) };
+    std::vector<std::vector<uint32_t>> lods{};
+    std::vector<float> lodErrors{};
+    buildLods(mesh, lodCount, lods, lodErrors);
+    for (size_t i = 0; i < lods.size(); i++)
+        printf("%s: LOD %zu, %zu triangles, error %.5f\n", output.c_str(), i + 1, lods[i].size() / 3, lodErrors[i]);
+    PackedVertices vertices{ packVertices(mesh, importedStreams, encoding) };
+    std::vector<char> image{ MeshFile::pack(mesh, vertices, lods, lodErrors, meshlets) };
+    if (!MeshFile::write(output, image))
+    {
+        fprintf(stderr, "Can't write %s\n", output.c_str());
+        return 1;
+    }
+    printf("%s: %zu vertices of %u bytes (%zu as floats), %zu meshlets, %zu bytes, built in %.2f ms\n", output.c_str(), mesh.vertexCount(),
+           vertices.stride, importedStride * sizeof(float), meshlets.size(), image.size(), millisecondsSince(start));
+    return 0;
+}
@@ -0,0 +1,287 @@
+#include "Importer.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <thread>
+
+namespace
+{
+    // Exact powers of ten in double, larger exponents fall back to pow()
+    const double powersOfTen[]
+    {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    // Indices as written are 1-based, absolute or relative to the end (negative). A relative
+    // index is kept relative to its chunk's start, and can point into an earlier chunk,
+    // until every chunk knows how many elements came before it.
+    const int noIndex{ INT_MIN };
+
+    struct ObjIndex
+    {
+        int  value{ noIndex };  // 0-based
+        bool relative{};
+    };
+
+    struct ObjCorner
+    {
+        ObjIndex position{};
+        ObjIndex texcoord{};
+        ObjIndex normal{};
+    };
+
+    struct ObjChunk
+    {
+        std::vector<float>      positions{};
+        std::vector<float>      texcoords{};
+        std::vector<float>      normals{};
+        std::vector<ObjCorner>  corners{};  // triangles
+    };
+
+    bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+    const char* skipBlank(const char* at, const char* end)
+    {
+        while (at < end && isBlank(*at))
+            at++;
+        return at;
+    }
+
+    const char* readFloats(const char* at, const char* end, int count, std::vector<float>& out)
+    {
+        for (int i = 0; i < count; i++)
+        {
+            float value{};
+            at = parseFloat(skipBlank(at, end), end, value);
+            out.push_back(value);
+        }
+        return at;
+    }
+
+    ObjIndex encodeIndex(long value, size_t localCount)
+    {
+        if (value > 0)
+            return { static_cast<int>(value - 1), false };
+        if (value < 0)
+            return { static_cast<int>(static_cast<long>(localCount) + value), true };
+        return {};
+    }
+
+    const char* readIndex(const char* at, const char* end, size_t localCount, ObjIndex& out)
+    {
+        bool negative{ at < end && *at == '-' };
+        if (negative)
+            at++;
+        long value{};
+        const char* start{ at };
+        while (at < end && *at >= '0' && *at <= '9')
+            value = value * 10 + (*at++ - '0');
+        if (at != start)
+            out = encodeIndex(negative ? -value : value, localCount);
+        return at;
+    }
+
+    void parseChunk(const char* at, const char* end, ObjChunk& chunk)
+    {
+        std::vector<ObjCorner> polygon{};
+        while (at < end)
+        {
+            at = skipBlank(at, end);
+            const char* lineEnd{ std::find(at, end, '\n') };
+
+            if (lineEnd - at > 1 && at[0] == 'v' && isBlank(at[1]))
+                readFloats(at + 2, lineEnd, 3, chunk.positions);
+            else if (lineEnd - at > 2 && at[0] == 'v' && at[1] == 't' && isBlank(at[2]))
+                readFloats(at + 3, lineEnd, 2, chunk.texcoords);
+            else if (lineEnd - at > 2 && at[0] == 'v' && at[1] == 'n' && isBlank(at[2]))
+                readFloats(at + 3, lineEnd, 3, chunk.normals);
+            else if (lineEnd - at > 1 && at[0] == 'f' && isBlank(at[1]))
+            {
+                polygon.clear();
+                const char* cursor{ at + 2 };
+                while ((cursor = skipBlank(cursor, lineEnd)) < lineEnd)
+                {
+                    ObjCorner corner{};
+                    cursor = readIndex(cursor, lineEnd, chunk.positions.size() / 3, corner.position);
+                    if (cursor < lineEnd && *cursor == '/')
+                    {
+                        cursor = readIndex(cursor + 1, lineEnd, chunk.texcoords.size() / 2, corner.texcoord);
+                        if (cursor < lineEnd && *cursor == '/')
+                            cursor = readIndex(cursor + 1, lineEnd, chunk.normals.size() / 3, corner.normal);
+                    }
+                    if (corner.position.value == noIndex)
+                        break; // garbage, keep what was read so far
+                    polygon.push_back(corner);
+                    while (cursor < lineEnd && !isBlank(*cursor))
+                        cursor++;
+                }
+                // Fan: (0, i, i + 1)
+                for (size_t i = 1; i + 1 < polygon.size(); i++)
+                {
+                    chunk.corners.push_back(polygon[0]);
+                    chunk.corners.push_back(polygon[i]);
+                    chunk.corners.push_back(polygon[i + 1]);
+                }
+            }
+            at = lineEnd + (lineEnd < end ? 1 : 0);
+        }
+    }
+
+    int resolve(ObjIndex index, size_t base, size_t count)
+    {
+        if (index.value == noIndex)
+            return -1;
+        long long absolute{ index.relative ? static_cast<long long>(base) + index.value : index.value };
+        return absolute >= 0 && absolute < static_cast<long long>(count) ? static_cast<int>(absolute) : -1;
+    }
+}
+
+const char* parseFloat(const char* at, const char* end, float& out)
+{
+    bool negative{ false };
+    if (at < end && (*at == '-' || *at == '+'))
+        negative = *at++ == '-';
+
+    uint64_t mantissa{};
+    int exponent{}, digits{};
+    for (; at < end && *at >= '0' && *at <= '9'; at++)
+    {
+        if (digits++ < 19)
+            mantissa = mantissa * 10 + (*at - '0');
+        else
+            exponent++; // past 19 digits only the magnitude matters
+    }
+    if (at < end && *at == '.')
+    {
+        for (at++; at < end && *at >= '0' && *at <= '9'; at++)
+        {
+            if (digits++ < 19)
+            {
+                mantissa = mantissa * 10 + (*at - '0');
+                exponent--;
+            }
+        }
+    }
+    if (at < end && (*at == 'e' || *at == 'E'))
+    {
+        const char* mark{ at++ };
+        bool negativeExponent{ false };
+        if (at < end && (*at == '-' || *at == '+'))
+            negativeExponent = *at++ == '-';
+        if (at < end && *at >= '0' && *at <= '9')
+        {
+            int value{};
+            for (; at < end && *at >= '0' && *at <= '9'; at++)
+                value = std::min(value * 10 + (*at - '0'), 100000);
+            exponent += negativeExponent ? -value : value;
+        }
+        else
+        {
+            at = mark; // "1e" is 1 followed by junk
+        }
+    }
+
+    double value{ static_cast<double>(mantissa) };
+    int magnitude{ exponent < 0 ? -exponent : exponent };
+    double scale{ magnitude <= 22 ? powersOfTen[magnitude] : std::pow(10.0, magnitude) };
+    value = exponent < 0 ? value / scale : value * scale;
+    out = static_cast<float>(negative ? -value : value);
+    return at;
+}
+
+bool parseObj(const char* text, size_t size, unsigned threads, ImportedMesh& out, std::string& error)
+{
+    out = ImportedMesh{};
+
+    // Chunks end after a newline so no line is split; tiny files stay on one thread
+    const size_t minimumChunk{ 1 << 20 };
+    threads = std::max(1u, std::min<unsigned>(threads, static_cast<unsigned>(size / minimumChunk + 1)));
+    std::vector<ObjChunk> chunks(threads);
+    std::vector<const char*> bounds{ text };
+    for (unsigned i = 1; i < threads; i++)
+    {
+        const char* cut{ std::max(bounds.back(), text + size * i / threads) };
+        cut = std::find(cut, text + size, '\n');
+        bounds.push_back(cut < text + size ? cut + 1 : cut);
+    }
+    bounds.push_back(text + size);
+
+    std::vector<std::thread> workers{};
+    for (unsigned i = 1; i < threads; i++)
+        workers.emplace_back(parseChunk, bounds[i], bounds[i + 1], std::ref(chunks[i]));
+    parseChunk(bounds[0], bounds[1], chunks[0]);
+    for (std::thread& worker : workers)
+        worker.join();
+
+    // Rebase chunk-local indices and flatten into one soup
+    std::vector<float> positions{}, texcoords{}, normals{};
+    std::vector<size_t> positionBase{}, texcoordBase{}, normalBase{};
+    for (const ObjChunk& chunk : chunks)
+    {
+        positionBase.push_back(positions.size() / 3);
+        texcoordBase.push_back(texcoords.size() / 2);
+        normalBase.push_back(normals.size() / 3);
+        positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+        texcoords.insert(texcoords.end(), chunk.texcoords.begin(), chunk.texcoords.end());
+        normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+    }
+
+    size_t cornerCount{};
+    for (const ObjChunk& chunk : chunks)
+        cornerCount += chunk.corners.size();
+    out.positions.reserve(cornerCount * 3);
+
+    bool hasTexcoords{ !texcoords.empty() }, hasNormals{ !normals.empty() };
+    size_t dropped{};
+    for (size_t c = 0; c < chunks.size(); c++)
+    {
+        const std::vector<ObjCorner>& corners{ chunks[c].corners };
+        for (size_t i = 0; i + 2 < corners.size(); i += 3)
+        {
+            int position[3], texcoord[3], normal[3];
+            bool valid{ true };
+            for (int k = 0; k < 3; k++)
+            {
+                position[k] = resolve(corners[i + k].position, positionBase[c], positions.size() / 3);
+                texcoord[k] = resolve(corners[i + k].texcoord, texcoordBase[c], texcoords.size() / 2);
+                normal[k] = resolve(corners[i + k].normal, normalBase[c], normals.size() / 3);
+                valid = valid && position[k] >= 0;
+            }
+            if (!valid)
+            {
+                dropped++;
+                continue;
+            }
+            for (int k = 0; k < 3; k++)
+            {
+                out.positions.insert(out.positions.end(), &positions[position[k] * 3], &positions[position[k] * 3] + 3);
+                if (hasTexcoords)
+                {
+                    const float zero[2]{};
+                    const float* uv{ texcoord[k] >= 0 ? &texcoords[texcoord[k] * 2] : zero };
+                    out.texcoords.insert(out.texcoords.end(), uv, uv + 2);
+                }
+                if (hasNormals)
+                {
+                    const float zero[3]{};
+                    const float* n{ normal[k] >= 0 ? &normals[normal[k] * 3] : zero };
+                    out.normals.insert(out.normals.end(), n, n + 3);
+                }
+            }
+        }
+    }
+
+    if (dropped)
+        fprintf(stderr, "warning: %zu triangles with invalid position indices skipped\n", dropped);
+    if (out.positions.empty())
+    {
+        error = "no triangles";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,63 @@
+#version 450 core
+
+// Cluster culling, dispatched by ClusterCullingPass: one invocation per meshlet of every
+// instance of a mesh. A meshlet that is outside the frustum, hidden in the Hi-Z pyramid or
+// turned away from the camera as a whole is dropped; each survivor appends its own
+// one-instance draw, and the indirect count draw submits as many as were appended.
+
+#include "Culling.glsl"
+
+layout (local_size_x = 64) in;
+
+// MeshFile.h Meshlet
+struct Meshlet
+{
+	vec4  sphere;	// mesh space, xyz center, w radius
+	vec4  cone;		// xyz axis, w cutoff
+	uvec4 range;	// first index into the pool, index count, vertex count
+};
+
+layout (std140, binding = 2) uniform ClusterUniforms
+{
+	mat4 meshToQuantized;	// undoes the position decode folded into the instance transforms
+	uint meshletCount;
+	uint instanceCount;
+	int  baseVertex;
+	float facing;			// -1 when the view projection mirrors and front faces point away
+};
+
+layout (std430, binding = 0) readonly buffer Meshlets { Meshlet meshlets[]; };
+layout (std430, binding = 1) readonly buffer Models { mat4 models[]; };
+layout (std430, binding = 2) writeonly buffer ClusterDraws { DrawCommand clusterDraws[]; };
+layout (std430, binding = 3) buffer ClusterDrawCount { uint clusterDrawCount; };
+
+// Sphere based cone test: true when every face of the cluster points away from the camera.
+// Holds for rotation, translation and uniform scale, which keep mat3(model) * axis a normal.
+bool backfacing(vec3 center, float radius, vec3 axis, float cutoff)
+{
+	if (camera.w == 0.0)
+		return dot(-normalize(camera.xyz), axis) >= cutoff;
+	vec3 view = center - camera.xyz / camera.w;
+	return dot(view, axis) >= cutoff * length(view) + radius;
+}
+
+void main(void)
+{
+	uint invocation = gl_GlobalInvocationID.x;
+	if (invocation >= meshletCount * instanceCount)
+		return;
+
+	uint instance = invocation / meshletCount;
+	Meshlet meshlet = meshlets[invocation % meshletCount];
+	mat4 model = models[instance] * meshToQuantized;
+
+	float scale = max(length(model[0].xyz), max(length(model[1].xyz), length(model[2].xyz)));
+	vec4 sphere = vec4((model * vec4(meshlet.sphere.xyz, 1.0)).xyz, meshlet.sphere.w * scale);
+	if (!insideFrustum(sphere) || occluded(sphere))
+		return;
+	if (meshlet.cone.w < 1.0 && backfacing(sphere.xyz, sphere.w, facing * normalize(mat3(model) * meshlet.cone.xyz), meshlet.cone.w))
+		return;
+
+	uint slot = atomicAdd(clusterDrawCount, 1u);
+	clusterDraws[slot] = DrawCommand(meshlet.range.y, 1u, meshlet.range.x, baseVertex, instance);
+}
@@ -1,8 +1,63 @@
 #version 450 core
 
-layout (local_size_x = 32, local_size_y = 32) in;
+// GPU culling, dispatched by CullingPass: one workgroup row per draw, one invocation per
+// instance of it. An instance is tested against the frustum, then against the Hi-Z pyramid
+// of the previous frame's depth. Visible instances pick a LOD from their projected size,
+// append their model matrix to that LOD's compacted stream and bump its draw's instance
+// count, the indirect draws then only see the survivors.
+
+#include "Culling.glsl"
+
+layout (local_size_x = 64) in;
+
+layout (std430, binding = 0) readonly buffer SourceDraws { DrawCommand sourceDraws[]; };
+layout (std430, binding = 1) buffer CulledDraws { DrawCommand culledDraws[]; };
+layout (std430, binding = 2) readonly buffer InstanceBounds { vec4 bounds[]; };	// xyz center, w radius
+layout (std430, binding = 3) readonly buffer SourceModels { mat4 sourceModels[]; };
+layout (std430, binding = 4) writeonly buffer CulledModels { mat4 culledModels[]; };
+
+// MeshFile.h MeshLod
+struct Lod
+{
+	uint  firstIndex;
+	uint  indexCount;
+	float error;	// relative to the mesh radius
+	uint  reserved;
+};
+
+layout (std430, binding = 5) readonly buffer SourceLods { Lod sourceLods[]; };	// lodSlots per draw, finest first
+
+layout (location = 0) uniform uint lodSlots;	// culled draws per source draw, one per LOD
+
+// LodSelector::select(): the coarsest LOD whose error covers at most the pixel budget
+uint selectLod(uint draw, vec4 sphere)
+{
+	float scale = lodSelection.x;
+	float distance = camera.w == 0.0 ? 1.0 : length(sphere.xyz - camera.xyz) - sphere.w;
+	if (scale <= 0.0 || distance <= 0.0)
+		return 0u;
+
+	float budget = distance / (sphere.w * scale);
+	uint lod = 0u;
+	while (lod + 1u < lodSlots && sourceLods[draw * lodSlots + lod + 1u].indexCount != 0u &&
+	       sourceLods[draw * lodSlots + lod + 1u].error <= budget)
+		lod++;
+	return lod;
+}
 
 void main(void)
 {
-	//Do nothing;
-}
\ No newline at end of file
+	uint draw = gl_WorkGroupID.y;
+	DrawCommand source = sourceDraws[draw];
+	if (gl_GlobalInvocationID.x >= source.instanceCount)
+		return;
+
+	uint instance = source.baseInstance + gl_GlobalInvocationID.x;
+	vec4 sphere = bounds[instance];
+	if (!insideFrustum(sphere) || occluded(sphere))
+		return;
+
+	uint target = draw * lodSlots + selectLod(draw, sphere);
+	uint slot = atomicAdd(culledDraws[target].instanceCount, 1u);
+	culledModels[culledDraws[target].baseInstance + slot] = sourceModels[instance];
+}
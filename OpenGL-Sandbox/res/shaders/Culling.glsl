@@ -0,0 +1,67 @@
+#pragma once
+
+// Shared by the culling passes (CullingPass.h, ClusterCullingPass.h): glMultiDrawElementsIndirect
+// records and the frustum and Hi-Z occlusion tests of world space bounding spheres.
+
+struct DrawCommand
+{
+	uint count;
+	uint instanceCount;
+	uint firstIndex;
+	int  baseVertex;
+	uint baseInstance;
+};
+
+layout (std140, binding = 1) uniform CullUniforms
+{
+	vec4 frustum[6];	// world space planes of the view projection, normals inwards
+	mat4 occlusionViewProjection;	// the pyramid's depth was rendered with this one
+	vec4 pyramid;	// xy depth size, z levels, w 0 while there is no pyramid yet
+	vec4 camera;	// world position, or with w 0 the direction towards an orthographic camera
+	vec4 lodSelection;	// x LodSelector::scale, 0 keeps LOD 0
+};
+
+layout (binding = 1) uniform sampler2D depthPyramid;	// r nearest, g farthest, see DepthPyramid.glsl
+
+bool insideFrustum(vec4 sphere)
+{
+	for (int i = 0; i < 6; i++)
+		if (dot(frustum[i].xyz, sphere.xyz) + frustum[i].w < -sphere.w)
+			return false;
+	return true;
+}
+
+// Screen rectangle and nearest depth of the sphere's box; hidden when the farthest depth
+// already rendered over that rectangle is in front of it. Level 0 texels cover 2x2 depth
+// texels, the level picked here makes the rectangle span at most 2x2 texels.
+bool occluded(vec4 sphere)
+{
+	if (pyramid.w == 0.0)
+		return false;
+
+	vec2 lo = vec2(1.0), hi = vec2(0.0);
+	float nearest = 1.0;
+	for (int i = 0; i < 8; i++)
+	{
+		vec3 corner = sphere.xyz + sphere.w * vec3((i & 1) != 0 ? 1.0 : -1.0, (i & 2) != 0 ? 1.0 : -1.0, (i & 4) != 0 ? 1.0 : -1.0);
+		vec4 clip = occlusionViewProjection * vec4(corner, 1.0);
+		if (clip.w <= 0.0)
+			return false;	// reaches behind the camera
+		vec3 ndc = clip.xyz / clip.w;
+		lo = min(lo, ndc.xy);
+		hi = max(hi, ndc.xy);
+		nearest = min(nearest, ndc.z * 0.5 + 0.5);
+	}
+
+	ivec2 depthSize = ivec2(pyramid.xy);
+	ivec2 first = clamp(ivec2(floor((lo * 0.5 + 0.5) * vec2(depthSize))), ivec2(0), depthSize - 1);
+	ivec2 last = clamp(ivec2(floor((hi * 0.5 + 0.5) * vec2(depthSize))), ivec2(0), depthSize - 1);
+	int extent = max(last.x - first.x, last.y - first.y) + 1;
+	int level = clamp(int(ceil(log2(float(extent)))) - 1, 0, int(pyramid.z) - 1);
+
+	first >>= level + 1;
+	last >>= level + 1;
+	float farthest = max(max(texelFetch(depthPyramid, first, level).g, texelFetch(depthPyramid, ivec2(last.x, first.y), level).g),
+	                     max(texelFetch(depthPyramid, ivec2(first.x, last.y), level).g, texelFetch(depthPyramid, last, level).g));
+	return nearest > farthest;
+}
@@ -0,0 +1,83 @@
+#version 450 core
+
+// Hi-Z build, dispatched by DepthPyramid. A workgroup turns a 64x64 texel tile of the source
+// into up to 6 levels in one go: the source is read once, every further level is reduced
+// from the previous one in shared memory and written straight out. r is the nearest depth
+// of a texel's footprint, g the farthest.
+
+layout (local_size_x = 16, local_size_y = 16) in;
+
+layout (binding = 0) uniform sampler2D source;	// depth, or the pyramid's last level so far
+layout (rg32f, binding = 0) uniform writeonly image2D levels[6];
+
+layout (location = 0) uniform int sourceLevel;
+layout (location = 1) uniform int levelCount;	// written by this dispatch, 1 to 6
+layout (location = 2) uniform int fromDepth;	// source is a depth texture, r only
+
+shared vec2 tile[16][16];
+
+vec2 fetchSource(ivec2 texel)
+{
+	// Past the edge repeats the last texel, which keeps min/max conservative
+	ivec2 size = textureSize(source, sourceLevel);
+	vec2 value = texelFetch(source, min(texel, size - 1), sourceLevel).rg;
+	return fromDepth != 0 ? value.rr : value;
+}
+
+vec2 reduce(vec2 a, vec2 b, vec2 c, vec2 d)
+{
+	return vec2(min(min(a.x, b.x), min(c.x, d.x)), max(max(a.y, b.y), max(c.y, d.y)));
+}
+
+// Constant indices only, image arrays can't be indexed dynamically everywhere
+void store(int level, ivec2 texel, vec2 value)
+{
+	switch (level)
+	{
+	case 0: imageStore(levels[0], texel, vec4(value, 0.0, 0.0)); break;
+	case 1: imageStore(levels[1], texel, vec4(value, 0.0, 0.0)); break;
+	case 2: imageStore(levels[2], texel, vec4(value, 0.0, 0.0)); break;
+	case 3: imageStore(levels[3], texel, vec4(value, 0.0, 0.0)); break;
+	case 4: imageStore(levels[4], texel, vec4(value, 0.0, 0.0)); break;
+	case 5: imageStore(levels[5], texel, vec4(value, 0.0, 0.0)); break;
+	}
+}
+
+void main(void)
+{
+	ivec2 local = ivec2(gl_LocalInvocationID.xy);
+	ivec2 group = ivec2(gl_WorkGroupID.xy);
+
+	// First level: a 2x2 block per invocation, from 4x4 source texels
+	vec2 block[4];
+	for (int i = 0; i < 4; i++)
+	{
+		ivec2 texel = group * 32 + local * 2 + ivec2(i & 1, i >> 1);
+		ivec2 s = texel * 2;
+		block[i] = reduce(fetchSource(s), fetchSource(s + ivec2(1, 0)), fetchSource(s + ivec2(0, 1)), fetchSource(s + ivec2(1, 1)));
+		store(0, texel, block[i]);
+	}
+	if (levelCount == 1)
+		return;
+
+	vec2 value = reduce(block[0], block[1], block[2], block[3]);
+	store(1, group * 16 + local, value);
+	tile[local.y][local.x] = value;
+
+	// Each further level halves the invocations that have work
+	int width = 8;
+	for (int level = 2; level < levelCount; level++, width /= 2)
+	{
+		barrier();
+		bool working = local.x < width && local.y < width;
+		ivec2 s = local * 2;
+		if (working)
+			value = reduce(tile[s.y][s.x], tile[s.y][s.x + 1], tile[s.y + 1][s.x], tile[s.y + 1][s.x + 1]);
+		barrier();
+		if (working)
+		{
+			tile[local.y][local.x] = value;
+			store(level, group * width + local, value);
+		}
+	}
+}
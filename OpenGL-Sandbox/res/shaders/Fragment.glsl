@@ -1,8 +1,8 @@
 #version 450 core
 
-uniform Sampler2D s;
+layout (binding = 0) uniform sampler2D s;
 
-out vec4 color;
+layout(location = 0) out vec4 color;
 
 void main(void)
 {
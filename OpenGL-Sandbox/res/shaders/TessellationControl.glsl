@@ -1,18 +1,68 @@
 #version 450 core
 
+#include "Uniforms.glsl"
+
 layout(vertices = 3) out;
 
+layout(location = 1) in vec3 worldPosition[];	// Vertex.glsl's locations
+layout(location = 0) out vec3 patchPosition[];	// world space corners, the evaluation stage places vertices with them
+
+// The MAX_TESS_LEVEL variant key: a define for GLSL, specialized when loaded as SPIR-V
+// (glslang defines GL_SPIRV), see specializationOf()
+#ifdef GL_SPIRV
+layout(constant_id = 0) const float maxTessLevel = 64.0;
+#elif defined(MAX_TESS_LEVEL)
+const float maxTessLevel = MAX_TESS_LEVEL;
+#else
+const float maxTessLevel = 64.0;
+#endif
+
+// Dropped when every corner is outside the same clip plane
+bool outsideFrustum(void)
+{
+	for (int plane = 0; plane < 6; plane++)
+	{
+		bool outside = true;
+		for (int i = 0; i < 3; i++)
+		{
+			vec4 p = gl_in[i].gl_Position;
+			float side = (plane & 1) == 0 ? p.w + p[plane / 2] : p.w - p[plane / 2];
+			outside = outside && side < 0.0;
+		}
+		if (outside)
+			return true;
+	}
+	return false;
+}
+
+// The edge's length in target edge lengths, seen from its midpoint's distance. Both patches
+// of a shared edge compute the same level, so they meet without cracks.
+float edgeLevel(vec3 a, vec3 b)
+{
+	float distance = camera.w == 0.0 ? 1.0 : max(length((a + b) * 0.5 - camera.xyz), 1e-4);
+	return clamp(length(b - a) * tessellation.x / distance, 1.0, maxTessLevel);
+}
+
 void main(void)
 {
-	// Only if I am invocation 0 ...
+	patchPosition[gl_InvocationID] = worldPosition[gl_InvocationID];
+	gl_out[gl_InvocationID].gl_Position = gl_in[gl_InvocationID].gl_Position;
+
+	// One invocation sets the levels for the patch
 	if (gl_InvocationID == 0)
 	{
-		gl_TessLevelInner[0] = 4.0;
-		gl_TessLevelOuter[0] = 4.0;
-		gl_TessLevelOuter[1] = 4.0;
-		gl_TessLevelOuter[2] = 4.0;
+		if (outsideFrustum())
+		{
+			gl_TessLevelOuter[0] = 0.0;
+			gl_TessLevelOuter[1] = 0.0;
+			gl_TessLevelOuter[2] = 0.0;
+			gl_TessLevelInner[0] = 0.0;
+			return;
+		}
+		// Outer level i is the edge opposite corner i
+		gl_TessLevelOuter[0] = edgeLevel(worldPosition[1], worldPosition[2]);
+		gl_TessLevelOuter[1] = edgeLevel(worldPosition[2], worldPosition[0]);
+		gl_TessLevelOuter[2] = edgeLevel(worldPosition[0], worldPosition[1]);
+		gl_TessLevelInner[0] = max(gl_TessLevelOuter[0], max(gl_TessLevelOuter[1], gl_TessLevelOuter[2]));
 	}
-	// Everybody copies their input to their output
-	gl_out[gl_InvocationID].gl_Position =
-		gl_in[gl_InvocationID].gl_Position;
 }
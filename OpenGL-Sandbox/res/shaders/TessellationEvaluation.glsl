@@ -1,10 +1,17 @@
 #version 450 core
 
-layout(triangles, equal_spacing, cw) in;
+#include "Uniforms.glsl"
+
+// Counter-clockwise like the meshes, fractional so levels change without popping
+layout(triangles, fractional_odd_spacing, ccw) in;
+
+layout(location = 0) in vec3 patchPosition[];	// TessellationControl.glsl's locations
 
 void main(void)
 {
-	gl_Position = (gl_TessCoord.x * gl_in[0].gl_Position +
-		gl_TessCoord.y * gl_in[1].gl_Position +
-		gl_TessCoord.z * gl_in[2].gl_Position);
-}
\ No newline at end of file
+	// Placed in world space, where a displacement would go
+	vec3 world = gl_TessCoord.x * patchPosition[0] +
+		gl_TessCoord.y * patchPosition[1] +
+		gl_TessCoord.z * patchPosition[2];
+	gl_Position = mvp * vec4(world, 1.0);
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+// Per-draw constants, written into the app's streaming RingBuffer every frame
+layout (std140, binding = 0) uniform DrawUniforms
+{
+	mat4 mvp;			// view projection, the instances bring their model matrix
+	vec4 camera;		// LodSelector::camera: world position, or with w 0 the direction towards an orthographic one
+	vec4 tessellation;	// x LodSelector::scale for the target edge length in pixels
+};
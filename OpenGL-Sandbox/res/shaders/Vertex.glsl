@@ -1,8 +1,20 @@
 #version 450 core
 
-in vec4 position;
+#include "Uniforms.glsl"
+#include "VertexFormat.glsl"
+
+layout (location = 0) in vec4 position;
+layout (location = 1) in vec2 normal;  // octahedral
+layout (location = 4) in mat4 model;   // per instance, includes the position decode
+
+// Locations are explicit: baked stages are compiled one by one, so nothing matches them by name
+layout (location = 0) out vec3 vertexNormal;
+layout (location = 1) out vec3 worldPosition;    // for the tessellation stages
 
 void main(void)
 {
-	gl_Position = position;
+	vec4 world = model * vec4(position.xyz, 1.0);
+	vertexNormal = decodeOctahedral(normal);
+	worldPosition = world.xyz;
+	gl_Position = mvp * world;
 }
\ No newline at end of file
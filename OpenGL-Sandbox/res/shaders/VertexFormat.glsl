@@ -0,0 +1,13 @@
+#pragma once
+
+// Decoding for VertexEncoding::Quantized meshes. GL already turns the normalized
+// integers and halves into floats; the bounds mapping of positions is folded into the
+// instance transform (MeshRange::decode), what is left is unfolding the octahedral normal.
+
+vec3 decodeOctahedral(vec2 encoded)
+{
+	vec3 n = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+	float fold = max(-n.z, 0.0);
+	n.xy += vec2(n.x >= 0.0 ? -fold : fold, n.y >= 0.0 ? -fold : fold);
+	return normalize(n);
+}
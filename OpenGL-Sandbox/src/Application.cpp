@@ -4,67 +4,43 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <vector>
 #include <sstream>
 #include <cassert>
+#include <chrono>
+#include <cctype>
+#include <cstdlib>
+#include <cmath>
 #include <math.h>
 
 #include <glm/glm.hpp>
 #include <glm/trigonometric.hpp> //for glm::sin
 #include <glm/gtc/type_ptr.hpp> //for glm::value_ptr
-
-std::string parseShader(const std::string filePath) // gets string from shader file
-{
-    std::stringstream code{};
-    std::string line{};
-    std::ifstream file(filePath);
-
-    while (getline(file, line))
-    {
-        code << line << '\n';
-    }
-    file.close();
-
-    return code.str();
-};
-
-GLuint compileShaders(void)
-{
-    const int shadersCount = 6; // there is 6 shaders in OpenGL pipeline
-    struct Shader
-    {
-        int enabled{};
-        GLenum type{};
-        std::string path{};
-    };
-    Shader pipeline[shadersCount] =
-    {
-        {1, GL_VERTEX_SHADER,            "res/shaders/Vertex.glsl"},
-        {0, GL_TESS_CONTROL_SHADER,      "res/shaders/TessellationControl.glsl"},
-        {0, GL_TESS_EVALUATION_SHADER,   "res/shaders/TessellationEvaluation.glsl"},
-        {0, GL_GEOMETRY_SHADER,          "res/shaders/Geometry.glsl"},
-        {1, GL_FRAGMENT_SHADER,          "res/shaders/Fragment.glsl"},
-        {0, GL_COMPUTE_SHADER,           "res/shaders/Compute.glsl"}
-    };
-
-    GLuint program = glCreateProgram();
-
-    for (int i = 0; i < shadersCount; i++)
-    {
-        if (pipeline[i].enabled)
-        {
-            GLuint shaderObj{ glCreateShader(pipeline[i].type) };
-            std::string shaderSource{ parseShader(pipeline[i].path) };
-            const GLchar* shaderSrc{ shaderSource.c_str() };
-            glShaderSource(shaderObj, 1, &shaderSrc, NULL);
-            glCompileShader(shaderObj);
-            glAttachShader(program, shaderObj);
-            glDeleteShader(shaderObj);
-        }
-    }
-    glLinkProgram(program);
-
-    return program;
-};
+#include <glm/gtc/matrix_transform.hpp> //for glm::perspective
+#include <glm/gtc/packing.hpp> //for glm::packUnorm4x8
+
+#include "ClusterCullingPass.h"
+#include "CullingPass.h"
+#include "DepthPyramid.h"
+#include "DrawBatch.h"
+#include "FrameStats.h"
+#include "Hash.h"
+#include "HeadlessContext.h"
+#include "InstanceBuffer.h"
+#include "MeshBuilder.h"
+#include "MeshFile.h"
+#include "MeshOptimizer.h"
+#include "MeshPool.h"
+#include "ProgramCache.h"
+#include "ProgramQueue.h"
+#include "RingBuffer.h"
+#include "Shader.h"
+#include "ShaderArchive.h"
+#include "ShaderVariants.h"
+#include "ShaderWatcher.h"
+#include "SoftwareRasterizer.h"
+#include "Tessellator.h"
+#include "VertexFormat.h"
 
 void GLAPIENTRY MessageCallback(GLenum source,
                                 GLenum type,
@@ -79,31 +55,244 @@ void GLAPIENTRY MessageCallback(GLenum source,
         type, severity, message);
 };
 
+// res/shaders/Uniforms.glsl, std140
+struct DrawUniforms
+{
+    glm::mat4 mvp{ 1.0f };
+    glm::vec4 camera{ 0.0f };
+    glm::vec4 tessellation{ 0.0f };
+};
+
+struct LaunchOptions
+{
+    bool        headless{};          // --headless [frames]: no window, render into an FBO
+    int         frameCount{ 300 };   // frames to render before exiting in headless mode
+    std::string statsPath{};         // --stats <file>: per-frame timings as csv
+    bool        shaderCache{ true }; // --no-shader-cache: always compile from source
+    std::string meshPath{};              // --mesh <file.mesh>: drawn instead of the built-in cube
+    std::string shaderArchive{};         // --shader-archive <file.pak>: stages baked by ShaderBaker
+    int         instanceCount{};         // --instances [count]: benchmark grid of that many meshes (100000)
+    bool        gpuCulling{ true };      // --no-culling: draw every instance
+    float       lodPixelError{ 1.0f };   // --lod-error <pixels>: screen error a LOD may have, 0 draws LOD 0 only
+    float       tessellationPixels{};    // --tessellation [pixels]: patches split into edges of about that length (8)
+    float       maxTessellationLevel{ 64.0f }; // --max-tess-level <level>: cap of the patch levels, GL's minimum maximum by default
+    bool        tessellationReference{}; // --tessellation-reference: last frame's patches again on the CPU, implies --tessellation
+    bool        software{};              // --software [threads]: headless on SoftwareRasterizer, no GPU needed
+    unsigned    softwareThreads{};       // 0: every hardware thread
+    bool        selfTest{};              // --self-test: CPU checks with known results, exit status 1 if any fails
+    std::string dumpPath{};              // --dump <file>: headless last frame as raw RGBA8, bottom row first
+    std::string comparePath{};           // --compare <file>: exit status 1 unless the last frame equals that dump
+    std::string expectedHash{};          // --expect-hash <hex>: exit status 1 unless the last frame has that image hash
+};
+
+// Scene pass colors; Fragment.glsl fetches from a texture that is never created, and a fetch
+// from an incomplete texture returns (0, 0, 0, 1)
+const glm::vec4 clearColor{ 0.01f, 0.2f, 0.1f, 1.0f };
+const glm::vec4 fragmentColor{ 0.0f, 0.0f, 0.0f, 1.0f };
+
 class Application
 {
 public:
-    int startup()
+    int startup(const LaunchOptions& launchOptions)
+    {
+        options = launchOptions;
+        if (options.software)
+            return startupSoftware();
+
+        if (options.headless)
+        {
+            if (!headlessContext.create(4, 5))
+                return -1;
+
+            // Core profile context: GLEW needs this to load everything. A GLX build of GLEW
+            // still loads the GL entry points under EGL, it only fails to find a GLX display
+            glewExperimental = GL_TRUE;
+            GLenum glewStatus{ glewInit() };
+            if (glewStatus != GLEW_OK && glewStatus != GLEW_ERROR_NO_GLX_DISPLAY)
+            {
+                fprintf(stderr, "GLEW initialization error: %s\n", glewGetErrorString(glewStatus));
+                return -1;
+            }
+            glGetError(); // glewExperimental may leave GL_INVALID_ENUM behind
+        }
+        else
+        {
+            assert(glfwInit());
+
+            // Create a windowed mode window and its OpenGL context
+            window = glfwCreateWindow(width(), height(), "TOP TEXT", NULL, NULL);
+            if (!window)
+            {
+                glfwTerminate();
+                assert(0 && "Window creation error");
+            }
+            glfwMakeContextCurrent(window);
+            assert(glewInit() == GLEW_OK);
+
+            // GLFW hints
+            glfwSwapInterval(1);
+            glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE);
+        }
+
+        // The scene always renders offscreen, its depth is a texture the Hi-Z pass reads
+        if (!createOffscreenTarget())
+            return -1;
+        glEnable(GL_DEPTH_TEST);
+
+        // Compiling and linking our program, draws use a fallback until it is ready
+        if (options.shaderCache)
+            programCache.init();
+        programQueue.init(&programCache);
+        if (!options.shaderArchive.empty())
+        {
+            if (shaderArchive.open(options.shaderArchive))
+                programQueue.useArchive(&shaderArchive);
+            else
+                fprintf(stderr, "Can't use shader archive %s, compiling res/shaders instead\n", options.shaderArchive.c_str());
+        }
+        sceneVariants.init(&programQueue, defaultProgram());
+        std::vector<std::string> sceneKeys{};
+        if (options.tessellationPixels > 0.0f)
+            sceneKeys.push_back("TESSELLATION");
+        // A specialization constant of the baked module, only a variant of its own in GLSL
+        if (options.tessellationPixels > 0.0f && options.maxTessellationLevel != 64.0f)
+            sceneKeys.push_back("MAX_TESS_LEVEL=" + std::to_string(options.maxTessellationLevel));
+        program = sceneVariants.get(sceneKeys);
+        // The baked variants compile behind the scene's program, so the cache holds them all
+        // for the next launch; perf runs only build what they draw
+        if (!options.headless)
+            sceneVariants.warmUp(readVariantList());
+        glPatchParameteri(GL_PATCH_VERTICES, 3);
+        glGenQueries(1, &primitivesQuery);
+
+        // Hot reload while iterating on shaders; perf runs keep the file system quiet
+        if (!options.headless)
+            shaderWatcher.init();
+
+        MeshFile sceneMesh{};
+        openSceneMesh(sceneMesh);
+        // Pool sized for what the scene draws; the mapped file is not needed once it is copied
+        meshPool.init(sceneMesh.vertexSize(), sceneMesh.header().indexCount * sizeof(GLuint));
+        meshPool.add(sceneMesh, sceneRange);
+        if (options.tessellationReference)
+        {
+            // The reference indexes positions with what the file says, so only with checked indices
+            cpuPositions = fetchPositions(sceneMesh);
+            if (cpuPositions.size() != sceneMesh.header().vertexCount || !fetchIndices(sceneMesh, cpuIndices))
+            {
+                fprintf(stderr, "Scene mesh refused: no positions, or indices past its %u vertices\n", sceneMesh.header().vertexCount);
+                return -1;
+            }
+            cpuFirstIndex = sceneRange.lods[0].firstIndex - sceneMesh.lods()[0].firstIndex;
+        }
+        glBindVertexArray(meshPool.vertexArray());
+
+        if (options.instanceCount > 0)
+            setupInstanceGrid();
+        else
+            setupInstances({ glm::mat4{ 1.0f } });
+        // Meshes split into several meshlets are culled per cluster, everything else per instance.
+        // Meshlets only cover LOD 0, so copies of a mesh with LODs pick a LOD per instance instead.
+        if (options.gpuCulling && sceneRange.meshlets.size() > 1 && (sceneRange.lods.size() == 1 || instances.count() == 1))
+            clusterCulling.init(programQueue, sceneRange, instances);
+        if (options.gpuCulling)
+        {
+            culling.init(programQueue, instances, static_cast<GLuint>(sceneRange.lods.size()));
+            depthPyramid.init(programQueue, width(), height());
+        }
+        frameRing.init(64 * 1024);
+
+        //glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+        //glTextureStorage2D(texture, 1, GL_RGBA32F, 256, 256);
+
+        //float *data{ new float[256 * 256 * 4] };
+        //generateTexture(data, 256, 256);
+        //glTextureSubImage2D(texture, 0, 0, 0, 256, 256, GL_RGBA, GL_FLOAT, data);
+        //delete[] data;
+
+        return 0;
+    }
+
+    void render()
     {
-        assert(glfwInit());
+        if (options.software)
+        {
+            renderSoftware();
+            return;
+        }
+
+        /* Debug */
+        printf("%s\n", glGetString(GL_VERSION));
+        glEnable(GL_DEBUG_OUTPUT);
+        glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+        glDebugMessageCallback(MessageCallback, 0);
+
+        glLineWidth(4);       
 
-        // Create a windowed mode window and its OpenGL context
-        window = glfwCreateWindow(16 * windowSize, 9 * windowSize, "TOP TEXT", NULL, NULL);
-        if (!window)
+        // Updates
+        if (options.headless)
+        {
+            renderHeadless();
+        }
+        else
+        {
+            while (!glfwWindowShouldClose(window))
+            {
+                glBindFramebuffer(GL_FRAMEBUFFER, offscreenFbo);
+                drawFrame();
+                glBlitNamedFramebuffer(offscreenFbo, 0, 0, 0, width(), height(), 0, 0, width(), height(), GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+                glfwSwapBuffers(window);
+                glfwPollEvents();
+            }
+        }
+    }
+
+    // main's exit status: 1 once a check of the run failed
+    int exitStatus() const { return failed ? 1 : 0; }
+
+    void shutdown()
+    {
+        if (options.software)
+        {
+            softwareRasterizer.shutdown();
+            return;
+        }
+
+        depthPyramid.shutdown();
+        clusterCulling.shutdown();
+        culling.shutdown();
+        instances.shutdown();
+        meshPool.shutdown();
+        shaderWatcher.shutdown();
+        programQueue.shutdown();
+        shaderArchive.close();
+        frameRing.shutdown();
+
+        glDeleteFramebuffers(1, &offscreenFbo);
+        glDeleteRenderbuffers(1, &offscreenColor);
+        glDeleteTextures(1, &offscreenDepth);
+        glDeleteQueries(1, &primitivesQuery);
+        if (options.headless)
+        {
+            headlessContext.destroy();
+        }
+        else
         {
             glfwTerminate();
-            assert(0 && "Window creation error");
         }
-        glfwMakeContextCurrent(window);
-        assert(glewInit() == GLEW_OK);
+    }
 
-        // GLFW hints
-        glfwSwapInterval(1);
-        glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE);
+    friend void getKeysWASD(Application *app);
+    friend void xRay(Application* app);
 
-        // Compiling and linking our program
-        program = compileShaders();
+private:
+    int width() const { return 16 * windowSize; }
+    int height() const { return 9 * windowSize; }
 
-        // Data
+    // --mesh, or the built-in cube when there is none or it can't be opened
+    void openSceneMesh(MeshFile& sceneMesh)
+    {
         static const GLfloat vertexPositions[] =
         {
             -0.25f,  0.25f, -0.25f,
@@ -155,74 +344,380 @@ public:
             -0.25f,  0.25f, -0.25f
         };
 
-        glGenVertexArrays(1, &vao);
-        glBindVertexArray(vao);
+        if (!options.meshPath.empty() && !sceneMesh.open(options.meshPath))
+            fprintf(stderr, "Can't open mesh %s, drawing the built-in cube\n", options.meshPath.c_str());
+        if (!sceneMesh.isOpen())
+        {
+            // Only 8 of the 36 soup vertices are unique, the rest become indices
+            MeshBuilder builder{ 3 };
+            builder.addTriangles(vertexPositions, sizeof(vertexPositions) / (3 * sizeof(GLfloat)));
+            Mesh cube{ builder.take() };
+            optimizeMesh(cube, "cube", stdout);
+            sceneMesh.open(MeshFile::pack(cube, packVertices(cube), {}, {}, buildMeshlets(cube))); // 8 byte positions instead of 12
+        }
+    }
 
-        glGenBuffers(1, &buffer);
-        glBindBuffer(GL_ARRAY_BUFFER, buffer);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(vertexPositions), vertexPositions, GL_STATIC_DRAW);        
+    void drawFrame()
+    {
+        glClearColor(clearColor.r, clearColor.g, clearColor.b, clearColor.a);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+        programQueue.reload(shaderWatcher.poll());
+        programQueue.poll();
+        frameRing.beginFrame();
+
+        // Every object of the scene is one instance; the whole pass is one indirect draw,
+        // culled on the GPU once the compute program is ready. The culling pass picks LODs
+        // itself, without it the batch gets them per instance here.
+        LodSelector lods{ mvpMatrix, static_cast<float>(height()), options.lodPixelError };
+        bool clustered{ options.gpuCulling && clusterCulling.cull(frameRing, mvpMatrix, &depthPyramid) };
+        bool gpuLods{ !clustered && options.gpuCulling && culling.ready() };
+        drawBatch.clear();
+        if (gpuLods)
+        {
+            // One draw of every instance, the culling pass expands it into LODs
+            drawBatch.add(sceneRange, 0, static_cast<GLuint>(instances.count()));
+        }
+        else
+        {
+            for (GLsizei instance = 0; instance < instances.count(); instance++)
+                drawBatch.add(sceneRange, instance, 1, lods.select(sceneRange, instanceBounds[instance]));
+        }
+        bool culled{ gpuLods && culling.cull(frameRing, drawBatch, mvpMatrix, &depthPyramid, lods) };
+        batchDrawn = !clustered && !culled;
 
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
-        glEnableVertexAttribArray(0);
+        glUseProgram(programQueue.program(program));
 
-        //glCreateTextures(GL_TEXTURE_2D, 1, &texture);
-        //glTextureStorage2D(texture, 1, GL_RGBA32F, 256, 256);
+        // Per-frame constants go through the streaming ring, never glBufferSubData
+        if (RingBuffer::Allocation uniforms = frameRing.allocateUniform(sizeof(DrawUniforms)))
+        {
+            DrawUniforms& draw{ *static_cast<DrawUniforms*>(uniforms.data) };
+            draw.mvp = mvpMatrix;
+            draw.camera = lods.camera;
+            draw.tessellation = glm::vec4(LodSelector{ mvpMatrix, static_cast<float>(height()), options.tessellationPixels }.scale, 0.0f, 0.0f, 0.0f);
+            glBindBufferRange(GL_UNIFORM_BUFFER, 0, frameRing.buffer(), uniforms.offset, uniforms.size);
+        }
 
-        //float *data{ new float[256 * 256 * 4] };
-        //generateTexture(data, 256, 256);
-        //glTextureSubImage2D(texture, 0, 0, 0, 256, 256, GL_RGBA, GL_FLOAT, data);
-        //delete[] data;
+        // Triangles become patches once the tessellating program replaced the fallback
+        GLenum mode{ GL_TRIANGLES };
+        if (options.tessellationPixels > 0.0f)
+        {
+            mode = programQueue.ready(program) ? GL_PATCHES : GL_TRIANGLES;
+            glBeginQuery(GL_PRIMITIVES_GENERATED, primitivesQuery);
+        }
+        if (clustered)
+        {
+            // The cone test is a back face cull per cluster, the rasterizer has to agree with it
+            glEnable(GL_CULL_FACE);
+            clusterCulling.draw(mode);
+            glDisable(GL_CULL_FACE);
+        }
+        else if (culled)
+        {
+            culling.draw(mode);
+        }
+        else
+        {
+            drawBatch.submit(frameRing, mode);
+        }
+        if (options.tessellationPixels > 0.0f)
+            glEndQuery(GL_PRIMITIVES_GENERATED);
 
-        return 0;
+        // Next frame's occlusion culling tests against this depth; nothing reads it without culling
+        if (options.gpuCulling)
+            depthPyramid.build(offscreenDepth, mvpMatrix);
+        frameRing.endFrame();
     }
 
-    void render()
+    // Bounds are taken before the position decode is folded into the transforms
+    void setupInstances(std::vector<glm::mat4> models)
     {
-        /* Debug */
-        printf("%s\n", glGetString(GL_VERSION));
-        glEnable(GL_DEBUG_OUTPUT);
-        glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
-        glDebugMessageCallback(MessageCallback, 0);
+        instanceBounds.clear();
+        instanceBounds.reserve(models.size());
+        for (glm::mat4& model : models)
+        {
+            instanceBounds.push_back(transformSphere(model, sceneRange.sphere));
+            model *= sceneRange.decode;
+        }
+        if (options.tessellationReference || options.software)
+            cpuModels = models;
+        if (!options.software)
+            instances.init(meshPool.vertexArray(), models, instanceBounds);
+    }
 
-        /* Data */
-        GLint textureLocation{ glGetUniformLocation(program, "s") };
+    // --instances: copies of the scene mesh one unit apart, the camera looks at the whole grid
+    void setupInstanceGrid()
+    {
+        setupInstances(instanceGrid(options.instanceCount, 1.0f));
 
-        glLineWidth(4);       
+        float side{ std::ceil(std::cbrt(static_cast<float>(options.instanceCount))) };
+        glm::vec3 eye{ glm::vec3(0.8f, 0.6f, 1.4f) * side };
+        glm::mat4 projection{ glm::perspective(glm::radians(60.0f), static_cast<float>(width()) / height(), 0.1f, 4.0f * side) };
+        mvpMatrix = projection * glm::lookAt(eye, glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    }
 
-        // Updates
-        while (!glfwWindowShouldClose(window))
+    // Color renderbuffer + depth texture of window size, stands in for the default framebuffer
+    bool createOffscreenTarget()
+    {
+        glGenRenderbuffers(1, &offscreenColor);
+        glBindRenderbuffer(GL_RENDERBUFFER, offscreenColor);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width(), height());
+
+        glGenTextures(1, &offscreenDepth);
+        glBindTexture(GL_TEXTURE_2D, offscreenDepth);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32F, width(), height());
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glGenFramebuffers(1, &offscreenFbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, offscreenFbo);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, offscreenColor);
+        glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, offscreenDepth, 0);
+
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
         {
-            glClearColor(0.01f, 0.2f, 0.1f, 1.0f);
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            fprintf(stderr, "Offscreen framebuffer is incomplete\n");
+            return false;
+        }
+        glViewport(0, 0, width(), height());
+        return true;
+    }
 
-            glUseProgram(program);
-            glDrawArrays(GL_TRIANGLES, 0, 3);
-            
-            glfwSwapBuffers(window);
-            glfwPollEvents();
+    // Fixed number of frames without vsync, every frame is timed and waited for
+    void renderHeadless()
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, offscreenFbo);
+        frameStats.init(options.frameCount);
+        GLuint triangles{ sceneRange.lods[0].indexCount / 3 };
+        frameStats.setWorkload(static_cast<double>(triangles) * instances.count());
+
+        for (int frame = 0; frame < options.frameCount; frame++)
+        {
+            frameStats.beginFrame();
+            drawFrame();
+            frameStats.endFrame();
         }
-        glDisableVertexArrayAttrib(vao, 0);
+
+        printf("Renderer: %s\n", glGetString(GL_RENDERER));
+        std::vector<uint32_t> pixels(size_t(width()) * height());
+        glReadPixels(0, 0, width(), height(), GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        checkImage(pixels);
+        if (clusterCulling.ready())
+            printf("Cluster culling: %u of %u meshlet instance(s) visible in the last frame\n", clusterCulling.visibleClusters(), clusterCulling.clusterCount());
+        else if (culling.ready())
+            printf("GPU culling: %u of %d instance(s) visible in the last frame\n", culling.visibleInstances(), instances.count());
+
+        if (options.tessellationPixels > 0.0f)
+        {
+            GLuint64 generated{};
+            glGetQueryObjectui64v(primitivesQuery, GL_QUERY_RESULT, &generated);
+            printf("Tessellation: %llu primitive(s) generated in the last frame, %.1f pixel edges\n",
+                   static_cast<unsigned long long>(generated), options.tessellationPixels);
+            if (options.tessellationReference)
+                runTessellationReference(generated);
+        }
+
+        // LODs and culling change what is drawn, the rate is of the last frame's triangles
+        if (!clusterCulling.ready())
+            frameStats.setWorkload(static_cast<double>(culling.ready() ? culling.visibleTriangles() : drawBatch.triangleCount()));
+        printf("Scene: %d instance(s) of %u triangles, %zu LOD(s), %zu indirect draw(s) per frame\n", instances.count(), triangles,
+               sceneRange.lods.size(), drawBatch.drawCount());
+        frameStats.report(stdout);
+        if (!options.statsPath.empty())
+            frameStats.writeCsv(options.statsPath);
+        frameStats.shutdown();
     }
 
+    // --software: no context at all, the scene streams stay on the CPU for SoftwareRasterizer
+    int startupSoftware()
+    {
+        if (!softwareRasterizer.init(width(), height(), options.softwareThreads))
+            return -1;
+
+        MeshFile sceneMesh{};
+        openSceneMesh(sceneMesh);
+        describeMesh(sceneMesh, 0, 0, sceneRange);
+        cpuPositions = fetchPositions(sceneMesh);
+        if (cpuPositions.size() != sceneMesh.header().vertexCount || !fetchIndices(sceneMesh, cpuIndices))
+        {
+            fprintf(stderr, "Scene mesh refused: no positions, or indices past its %u vertices\n", sceneMesh.header().vertexCount);
+            return -1;
+        }
+        if (options.instanceCount > 0)
+            setupInstanceGrid();
+        else
+            setupInstances({ glm::mat4{ 1.0f } });
+        softwareRasterizer.setGeometry(cpuPositions.data(), 0, cpuIndices.data(), 0, cpuModels.data());
+        return 0;
+    }
 
-    void shutdown()
+    // renderHeadless() on the CPU backend: the same batch the GL path draws without culling,
+    // LODs picked per instance, timed on the CPU; the image hash compares runs and machines
+    void renderSoftware()
     {
-        glDeleteVertexArrays(1, &vao);
-        glDeleteProgram(program);
-        glDeleteBuffers(1, &buffer);
-        glfwTerminate();
+        frameStats.init(options.frameCount, false);
+        GLsizei instanceCount{ static_cast<GLsizei>(cpuModels.size()) };
+        uint64_t rasterized{};
+        for (int frame = 0; frame < options.frameCount; frame++)
+        {
+            frameStats.beginFrame();
+            LodSelector lods{ mvpMatrix, static_cast<float>(height()), options.lodPixelError };
+            drawBatch.clear();
+            for (GLsizei instance = 0; instance < instanceCount; instance++)
+                drawBatch.add(sceneRange, instance, 1, lods.select(sceneRange, instanceBounds[instance]));
+            softwareRasterizer.clear(glm::packUnorm4x8(clearColor));
+            rasterized = drawBatch.submit(softwareRasterizer, mvpMatrix, glm::packUnorm4x8(fragmentColor));
+            frameStats.endFrame();
+        }
+
+        std::vector<uint32_t> pixels{};
+        softwareRasterizer.readPixels(pixels);
+        printf("Renderer: software, %u thread(s), %dx%d tiles\n", softwareRasterizer.threadCount(), SoftwareRasterizer::tileSize,
+               SoftwareRasterizer::tileSize);
+        checkImage(pixels);
+        printf("Software: %llu triangle(s) rasterized in the last frame after clipping\n", static_cast<unsigned long long>(rasterized));
+
+        frameStats.setWorkload(static_cast<double>(drawBatch.triangleCount()));
+        printf("Scene: %d instance(s) of %u triangles, %zu LOD(s), %zu indirect draw(s) per frame\n", instanceCount,
+               sceneRange.lods[0].indexCount / 3, sceneRange.lods.size(), drawBatch.drawCount());
+        frameStats.report(stdout);
+        if (!options.statsPath.empty())
+            frameStats.writeCsv(options.statsPath);
+        frameStats.shutdown();
     }
 
-    friend void getKeysWASD(Application *app);
-    friend void xRay(Application* app);
+    // The last frame of either backend, RGBA8 bottom row first. The hash compares runs and
+    // machines; --dump, --compare and --expect-hash make that a pass or fail.
+    void checkImage(const std::vector<uint32_t>& pixels)
+    {
+        size_t bytes{ pixels.size() * sizeof(uint32_t) };
+        uint64_t hash{ hashBytes(pixels.data(), bytes) };
+        printf("Image: %dx%d, hash %016llx\n", width(), height(), static_cast<unsigned long long>(hash));
+
+        if (!options.dumpPath.empty())
+        {
+            std::ofstream file(options.dumpPath, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(pixels.data()), bytes);
+            if (!file)
+            {
+                fprintf(stderr, "Can't write %s\n", options.dumpPath.c_str());
+                failed = true;
+            }
+        }
+        if (!options.comparePath.empty())
+        {
+            std::ifstream file(options.comparePath, std::ios::binary);
+            std::vector<uint32_t> reference(pixels.size());
+            file.read(reinterpret_cast<char*>(reference.data()), bytes);
+            if (!file || file.peek() != std::ifstream::traits_type::eof())
+            {
+                fprintf(stderr, "%s is not a %dx%d --dump\n", options.comparePath.c_str(), width(), height());
+                failed = true;
+            }
+            else
+            {
+                size_t differing{};
+                for (size_t i = 0; i < pixels.size(); i++)
+                    differing += pixels[i] != reference[i];
+                printf("Image: %zu pixel(s) differ from %s\n", differing, options.comparePath.c_str());
+                failed = failed || differing > 0;
+            }
+        }
+        if (!options.expectedHash.empty() && strtoull(options.expectedHash.c_str(), nullptr, 16) != hash)
+        {
+            printf("Image: hash mismatch, expected %s\n", options.expectedHash.c_str());
+            failed = true;
+        }
+    }
+
+    // --tessellation-reference: every patch of the last frame's batch through the CPU stages of
+    // Tessellator.h. The triangle count has to match the GPU's, a mismatch fails the run; the
+    // positions are hashed so changes to the reference show. Culled and clustered frames draw
+    // what only the GPU knows.
+    void runTessellationReference(GLuint64 generated)
+    {
+        if (!batchDrawn || !programQueue.ready(program))
+        {
+            printf("Tessellation reference: skipped, the last frame was culled on the GPU or not tessellated (try --no-culling)\n");
+            return;
+        }
+
+        LodSelector edges{ mvpMatrix, static_cast<float>(height()), options.tessellationPixels };
+        glm::vec4 camera{ cameraOf(mvpMatrix) };
+        TessellatedPatch patch{};
+        std::vector<glm::vec3> positions{}, points{};
+        uint64_t patches{}, triangles{}, pointCount{}, hash{ hashSeed };
+        auto start = std::chrono::steady_clock::now();
+        for (const DrawElementsIndirectCommand& draw : drawBatch.draws())
+        {
+            const GLuint* indices{ cpuIndices.data() + (draw.firstIndex - cpuFirstIndex) };
+            for (GLuint instance = draw.baseInstance; instance < draw.baseInstance + draw.instanceCount; instance++)
+            {
+                const glm::mat4& model{ cpuModels[instance] };
+                for (GLuint i = 0; i + 2 < draw.count; i += 3, patches++)
+                {
+                    glm::vec3 world[3]{};
+                    glm::vec4 clip[3]{};
+                    for (int k = 0; k < 3; k++)
+                    {
+                        world[k] = glm::vec3(model * glm::vec4(cpuPositions[indices[i + k]], 1.0f));
+                        clip[k] = mvpMatrix * glm::vec4(world[k], 1.0f);
+                    }
+                    // TessellationEvaluation.glsl's fractional_odd_spacing
+                    TessellationLevels levels{ patchLevels(clip, world, camera, edges.scale, options.maxTessellationLevel) };
+                    triangles += tessellateTriangle(levels, TessellationSpacing::FractionalOdd, patch);
+                    positions.clear();
+                    points.clear();
+                    evaluateTriangle(patch, world, positions);
+                    emitPoints(positions, patch.triangles, points);
+                    pointCount += points.size();
+                    hash = hashBytes(points.data(), points.size() * sizeof(glm::vec3), hash);
+                }
+            }
+        }
+        std::chrono::duration<double, std::milli> elapsed{ std::chrono::steady_clock::now() - start };
+
+        printf("Tessellation reference: %llu patch(es) into %llu triangle(s), %llu point(s), GPU generated %llu%s\n",
+               static_cast<unsigned long long>(patches), static_cast<unsigned long long>(triangles),
+               static_cast<unsigned long long>(pointCount), static_cast<unsigned long long>(generated),
+               triangles == generated ? "" : " (mismatch)");
+        failed = failed || triangles != generated;
+        printf("Tessellation reference: %.2f ms on the CPU, %.2f Mtris/s, points hash %016llx\n", elapsed.count(),
+               triangles / (elapsed.count() * 1000.0), static_cast<unsigned long long>(hash));
+    }
+
+    LaunchOptions   options{};
+    HeadlessContext headlessContext{};
+    FrameStats      frameStats{};
+    ProgramCache    programCache{};
+    ProgramQueue    programQueue{};
+    ShaderArchive   shaderArchive{};
+    ShaderVariants  sceneVariants{};
+    ShaderWatcher   shaderWatcher{};
+    GLuint          offscreenFbo{};
+    GLuint          offscreenColor{};
+    GLuint          offscreenDepth{};
 
-private:
     char            windowSize = 100; //default
     GLFWwindow*     window = NULL;
-    GLuint          program{};
-    GLuint          vao{};
-    GLuint          buffer{};
+    ProgramQueue::Handle program{};
+    MeshPool        meshPool{};
+    MeshRange       sceneRange{};
+    InstanceBuffer  instances{};
+    std::vector<glm::vec4> instanceBounds{};    // world spheres, CPU side LOD selection
+    DrawBatch       drawBatch{};
+    CullingPass     culling{};
+    ClusterCullingPass clusterCulling{};
+    DepthPyramid    depthPyramid{};
+    RingBuffer      frameRing{};
     GLuint          texture{};
+    GLuint          primitivesQuery{};          // --tessellation: what the last frame's draw generated
+    bool            batchDrawn{};               // the last frame drew drawBatch as is, not a culled copy
+    bool            failed{};                   // --tessellation-reference or an image check disagreed
+    std::vector<glm::vec3> cpuPositions{};      // --tessellation-reference and --software: the scene mesh as fetched,
+    std::vector<GLuint>    cpuIndices{};        // its whole index stream,
+    GLuint                 cpuFirstIndex{};     // where that starts in the pool
+    std::vector<glm::mat4> cpuModels{};         // and the instance transforms, decode folded in
+    SoftwareRasterizer     softwareRasterizer{};
     glm::mat4       mvpMatrix{ 1.0f };
 };
 
@@ -263,13 +758,130 @@ void xRay(Application* app)
     }
 }
 
-int main(void)
+// No window and no GL: checks of the CPU side against results known to be right
+bool runSelfTests()
+{
+    bool passed{ true };
+    passed = checkMeshOptimizer(stdout) && passed;
+    passed = checkVertexEncodings(stdout) && passed;
+    passed = checkTessellator(stdout) && passed;
+    printf("Self test %s\n", passed ? "passed" : "FAILED");
+    return passed;
+}
+
+// Usage: OpenGL-Sandbox [--headless [frames]] [--stats <file.csv>] [--no-shader-cache] [--shader-archive <file.pak>] [--mesh <file.mesh>] [--instances [count]] [--no-culling] [--lod-error <pixels>] [--tessellation [pixels]] [--max-tess-level <level>] [--tessellation-reference] [--software [threads]] [--dump <file>] [--compare <file>] [--expect-hash <hex>] [--self-test]
+LaunchOptions parseArguments(int argc, char** argv)
 {
+    LaunchOptions options{};
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg{ argv[i] };
+        if (arg == "--headless")
+        {
+            options.headless = true;
+            if (i + 1 < argc && isdigit(static_cast<unsigned char>(argv[i + 1][0])))
+                options.frameCount = atoi(argv[++i]);
+        }
+        else if (arg == "--no-shader-cache")
+        {
+            options.shaderCache = false;
+        }
+        else if (arg == "--mesh" && i + 1 < argc)
+        {
+            options.meshPath = argv[++i];
+        }
+        else if (arg == "--instances")
+        {
+            options.instanceCount = 100000;
+            if (i + 1 < argc && isdigit(static_cast<unsigned char>(argv[i + 1][0])))
+                options.instanceCount = atoi(argv[++i]);
+        }
+        else if (arg == "--no-culling")
+        {
+            options.gpuCulling = false;
+        }
+        else if (arg == "--tessellation")
+        {
+            options.tessellationPixels = 8.0f;
+            if (i + 1 < argc && isdigit(static_cast<unsigned char>(argv[i + 1][0])))
+                options.tessellationPixels = static_cast<float>(atof(argv[++i]));
+        }
+        else if (arg == "--max-tess-level" && i + 1 < argc)
+        {
+            options.maxTessellationLevel = glm::clamp(static_cast<float>(atof(argv[++i])), 1.0f, 64.0f);
+        }
+        else if (arg == "--tessellation-reference")
+        {
+            options.tessellationReference = true;
+            if (options.tessellationPixels <= 0.0f)
+                options.tessellationPixels = 8.0f;
+        }
+        else if (arg == "--software")
+        {
+            options.software = true;
+            options.headless = true;
+            if (i + 1 < argc && isdigit(static_cast<unsigned char>(argv[i + 1][0])))
+                options.softwareThreads = static_cast<unsigned>(atoi(argv[++i]));
+        }
+        else if (arg == "--self-test")
+        {
+            options.selfTest = true;
+        }
+        else if (arg == "--lod-error" && i + 1 < argc)
+        {
+            options.lodPixelError = static_cast<float>(atof(argv[++i]));
+        }
+        else if (arg == "--shader-archive" && i + 1 < argc)
+        {
+            options.shaderArchive = argv[++i];
+        }
+        else if (arg == "--dump" && i + 1 < argc)
+        {
+            options.dumpPath = argv[++i];
+        }
+        else if (arg == "--compare" && i + 1 < argc)
+        {
+            options.comparePath = argv[++i];
+        }
+        else if (arg == "--expect-hash" && i + 1 < argc)
+        {
+            options.expectedHash = argv[++i];
+        }
+        else if (arg == "--stats" && i + 1 < argc)
+        {
+            options.statsPath = argv[++i];
+        }
+        else
+        {
+            fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+        }
+    }
+    // Frame timings and the last frame's image only exist in the fixed-length headless run
+    if (!options.statsPath.empty() && !options.headless)
+    {
+        fprintf(stderr, "--stats implies --headless\n");
+        options.headless = true;
+    }
+    if ((!options.dumpPath.empty() || !options.comparePath.empty() || !options.expectedHash.empty()) && !options.headless)
+    {
+        fprintf(stderr, "--dump, --compare and --expect-hash imply --headless\n");
+        options.headless = true;
+    }
+    return options;
+}
+
+int main(int argc, char** argv)
+{
+    LaunchOptions options{ parseArguments(argc, argv) };
+    if (options.selfTest)
+        return runSelfTests() ? 0 : 1;
+
     Application app;
-    if (!app.startup()) //returns -1 if error
+    if (!app.startup(options)) //returns -1 if error
     {
         app.render();
         app.shutdown();
+        return app.exitStatus();
     }
-    return 0;
+    return 1;
 }
@@ -0,0 +1,126 @@
+#include "ClusterCullingPass.h"
+
+#include <cstdio>
+
+namespace
+{
+    const GLuint groupSize{ 64 }; // local_size_x of ClusterCulling.glsl
+
+    // res/shaders/ClusterCulling.glsl, std140
+    struct ClusterUniforms
+    {
+        glm::mat4 meshToQuantized{ 1.0f };
+        GLuint    meshletCount{};
+        GLuint    instanceCount{};
+        GLint     baseVertex{};
+        GLfloat   facing{ 1.0f };
+    };
+}
+
+bool ClusterCullingPass::init(ProgramQueue& programQueue, const MeshRange& meshRange, const InstanceBuffer& instanceBuffer)
+{
+    shutdown();
+    uint64_t clusters{ uint64_t(meshRange.meshlets.size()) * instanceBuffer.count() };
+    if (meshRange.meshlets.empty() || !instanceBuffer.count())
+        return false;
+    if (clusters > maxClusterDraws)
+    {
+        fprintf(stderr, "Cluster culling: %llu meshlet instances, more than %u\n", static_cast<unsigned long long>(clusters), maxClusterDraws);
+        return false;
+    }
+
+    queue = &programQueue;
+    program = queue->submit(computeProgram("res/shaders/ClusterCulling.glsl"));
+    instances = &instanceBuffer;
+    meshletCount = static_cast<GLuint>(meshRange.meshlets.size());
+    capacity = static_cast<GLuint>(clusters);
+    baseVertex = meshRange.baseVertex;
+    meshToQuantized = glm::inverse(meshRange.decode);
+    countDraw = GLEW_ARB_indirect_parameters != GL_FALSE;
+
+    glCreateBuffers(1, &meshletBuffer);
+    glNamedBufferStorage(meshletBuffer, meshRange.meshlets.size() * sizeof(Meshlet), meshRange.meshlets.data(), 0);
+    glCreateBuffers(1, &drawBuffer);
+    glNamedBufferStorage(drawBuffer, capacity * sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_STORAGE_BIT);
+    glCreateBuffers(1, &countBuffer);
+    glNamedBufferStorage(countBuffer, sizeof(GLuint), nullptr, GL_DYNAMIC_STORAGE_BIT);
+    return true;
+}
+
+void ClusterCullingPass::shutdown()
+{
+    GLuint buffers[]{ meshletBuffer, drawBuffer, countBuffer };
+    glDeleteBuffers(3, buffers);
+    meshletBuffer = drawBuffer = countBuffer = 0;
+    queue = nullptr;
+    instances = nullptr;
+    capacity = 0;
+    culled = false;
+}
+
+bool ClusterCullingPass::cull(RingBuffer& ring, const glm::mat4& viewProjection, const DepthPyramid* pyramid)
+{
+    culled = false;
+    if (!ready())
+        return false;
+
+    RingBuffer::Allocation cullUniforms{ ring.allocateUniform(sizeof(CullUniforms)) };
+    RingBuffer::Allocation clusterUniforms{ ring.allocateUniform(sizeof(ClusterUniforms)) };
+    if (!cullUniforms || !clusterUniforms)
+        return false;
+    setupCullUniforms(*static_cast<CullUniforms*>(cullUniforms.data), viewProjection, pyramid);
+    ClusterUniforms& cluster{ *static_cast<ClusterUniforms*>(clusterUniforms.data) };
+    cluster.meshToQuantized = meshToQuantized;
+    cluster.meshletCount = meshletCount;
+    cluster.instanceCount = static_cast<GLuint>(instances->count());
+    cluster.baseVertex = baseVertex;
+    // A right-handed view flips z into clip space; without that flip (say an identity
+    // matrix) counter-clockwise faces point away from the camera and the cones flip too
+    cluster.facing = glm::determinant(viewProjection) < 0.0f ? 1.0f : -1.0f;
+
+    // Unused records have to be empty draws when the whole buffer is submitted
+    const GLuint zero{};
+    glClearNamedBufferData(countBuffer, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+    if (!countDraw)
+        glClearNamedBufferData(drawBuffer, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+
+    glUseProgram(queue->program(program));
+    glBindBufferRange(GL_UNIFORM_BUFFER, 1, ring.buffer(), cullUniforms.offset, cullUniforms.size);
+    glBindBufferRange(GL_UNIFORM_BUFFER, 2, ring.buffer(), clusterUniforms.offset, clusterUniforms.size);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, meshletBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, instances->transforms());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, drawBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, countBuffer);
+    glDispatchCompute((capacity + groupSize - 1) / groupSize, 1, 1);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+    glBindTextureUnit(1, 0);
+
+    culled = true;
+    return true;
+}
+
+void ClusterCullingPass::draw(GLenum mode) const
+{
+    if (!culled)
+        return;
+
+    // baseInstance is the instance itself, the transforms are read uncompacted
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, drawBuffer);
+    if (countDraw)
+    {
+        glBindBuffer(GL_PARAMETER_BUFFER_ARB, countBuffer);
+        glMultiDrawElementsIndirectCountARB(mode, MeshPool::indexType, nullptr, 0, static_cast<GLsizei>(capacity), 0);
+    }
+    else
+    {
+        glMultiDrawElementsIndirect(mode, MeshPool::indexType, nullptr, static_cast<GLsizei>(capacity), 0);
+    }
+}
+
+GLuint ClusterCullingPass::visibleClusters() const
+{
+    GLuint visible{};
+    if (culled)
+        glGetNamedBufferSubData(countBuffer, 0, sizeof(visible), &visible);
+    return visible;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "CullingPass.h"
+#include "DepthPyramid.h"
+#include "InstanceBuffer.h"
+#include "MeshPool.h"
+#include "ProgramQueue.h"
+#include "RingBuffer.h"
+
+// Per-meshlet culling of every instance of one mesh with res/shaders/ClusterCulling.glsl:
+// frustum, Hi-Z occlusion and the normal cone, on top of what per-object culling does.
+// Each surviving meshlet appends a one-instance DrawElementsIndirectCommand to a GPU-only
+// buffer; draw() submits the appended count with glMultiDrawElementsIndirectCount. Without
+// ARB_indirect_parameters the buffer is cleared every frame and drawn at full capacity.
+//
+// The cone test drops clusters the rasterizer would cull anyway, so it is only right when
+// back faces are culled (counter-clockwise front faces, as MeshImporter writes them).
+class ClusterCullingPass
+{
+public:
+    static const GLuint maxClusterDraws{ 1u << 22 };   // meshlets x instances of one dispatch
+
+    // false when the mesh has no meshlets or there are too many clusters
+    bool init(ProgramQueue& programQueue, const MeshRange& meshRange, const InstanceBuffer& instanceBuffer);
+    void shutdown();
+
+    bool ready() const { return queue && queue->ready(program); }
+
+    // Leaves the compute program bound, use the draw program before draw()
+    bool cull(RingBuffer& ring, const glm::mat4& viewProjection, const DepthPyramid* pyramid = nullptr);
+    void draw(GLenum mode = GL_TRIANGLES) const;
+
+    GLuint clusterCount() const { return capacity; }
+    GLuint visibleClusters() const;     // of the last cull(), reads back, so only for reports
+
+private:
+    ProgramQueue*           queue{};
+    ProgramQueue::Handle    program{};
+    const InstanceBuffer*   instances{};
+    GLuint                  meshletBuffer{};
+    GLuint                  drawBuffer{};
+    GLuint                  countBuffer{};
+    GLuint                  meshletCount{};
+    GLuint                  capacity{};
+    GLint                   baseVertex{};
+    glm::mat4               meshToQuantized{ 1.0f };
+    bool                    countDraw{};    // ARB_indirect_parameters
+    bool                    culled{};
+};
@@ -0,0 +1,184 @@
+#include "CullingPass.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "MeshPool.h"
+
+namespace
+{
+    const GLuint groupSize{ 64 }; // local_size_x of Compute.glsl
+    const GLint lodSlotsLocation{ 0 }; // layout (location) of Compute.glsl's lodSlots
+
+    // Planes of a view projection matrix (Gribb/Hartmann), normals point inwards
+    void frustumPlanes(const glm::mat4& m, glm::vec4 (&planes)[6])
+    {
+        glm::vec4 rows[4]{};
+        for (int i = 0; i < 4; i++)
+            rows[i] = glm::vec4(m[0][i], m[1][i], m[2][i], m[3][i]);
+        for (int i = 0; i < 3; i++)
+        {
+            planes[2 * i] = rows[3] + rows[i];
+            planes[2 * i + 1] = rows[3] - rows[i];
+        }
+        for (glm::vec4& plane : planes)
+            plane /= glm::length(glm::vec3(plane));
+    }
+}
+
+void setupCullUniforms(CullUniforms& uniforms, const glm::mat4& viewProjection, const DepthPyramid* pyramid, float lodScale)
+{
+    frustumPlanes(viewProjection, uniforms.frustum);
+    uniforms.camera = cameraOf(viewProjection);
+    uniforms.lodSelection = glm::vec4(lodScale, 0.0f, 0.0f, 0.0f);
+
+    uniforms.occlusionViewProjection = glm::mat4{ 1.0f };
+    uniforms.pyramid = glm::vec4(0.0f);
+    if (pyramid && pyramid->valid())
+    {
+        uniforms.occlusionViewProjection = pyramid->viewProjection();
+        uniforms.pyramid = glm::vec4(glm::vec2(pyramid->depthSize()), static_cast<float>(pyramid->levels()), 1.0f);
+        glBindTextureUnit(1, pyramid->texture());
+    }
+}
+
+bool CullingPass::init(ProgramQueue& programQueue, const InstanceBuffer& instanceBuffer, GLuint lodSlotCount)
+{
+    shutdown();
+    if (!instanceBuffer.bounds())
+    {
+        fprintf(stderr, "Culling needs instance bounds\n");
+        return false;
+    }
+
+    GLint alignment{};
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    storageAlignment = std::max<GLsizeiptr>(alignment, 16);
+
+    queue = &programQueue;
+    program = queue->submit(computeProgram());
+    instances = &instanceBuffer;
+    lodSlots = std::max(lodSlotCount, 1u);
+    glCreateBuffers(1, &culledModels);
+    glNamedBufferStorage(culledModels, GLsizeiptr(lodSlots) * instances->count() * sizeof(glm::mat4), nullptr, 0);
+    return true;
+}
+
+void CullingPass::shutdown()
+{
+    if (culledModels)
+        glDeleteBuffers(1, &culledModels);
+    culledModels = 0;
+    queue = nullptr;
+    instances = nullptr;
+    lodSlots = 1;
+    drawCount = 0;
+}
+
+bool CullingPass::cull(RingBuffer& ring, const DrawBatch& batch, const glm::mat4& viewProjection, const DepthPyramid* pyramid,
+                       const LodSelector& lods)
+{
+    drawCount = 0;
+    const std::vector<DrawElementsIndirectCommand>& draws{ batch.draws() };
+    if (!ready() || draws.empty())
+        return false;
+
+    GLsizeiptr size{ static_cast<GLsizeiptr>(draws.size() * sizeof(DrawElementsIndirectCommand)) };
+    GLsizeiptr slotCount{ static_cast<GLsizeiptr>(draws.size() * lodSlots) };
+    RingBuffer::Allocation source{ ring.allocate(size, storageAlignment) };
+    RingBuffer::Allocation culled{ ring.allocate(slotCount * sizeof(DrawElementsIndirectCommand), storageAlignment) };
+    RingBuffer::Allocation lodTable{ ring.allocate(slotCount * sizeof(MeshLod), storageAlignment) };
+    RingBuffer::Allocation uniforms{ ring.allocateUniform(sizeof(CullUniforms)) };
+    if (!source || !culled || !lodTable || !uniforms)
+        return false;
+
+    // Slot l of a draw is its mesh's LOD l, compacting into the l-th copy of the instance range;
+    // slots past the mesh's LODs stay empty draws. One slot draws the batch's own range.
+    GLuint widest{};
+    memcpy(source.data, draws.data(), size);
+    DrawElementsIndirectCommand* counters{ static_cast<DrawElementsIndirectCommand*>(culled.data) };
+    MeshLod* slots{ static_cast<MeshLod*>(lodTable.data) };
+    for (size_t i = 0; i < draws.size(); i++)
+    {
+        const MeshRange& mesh{ *batch.meshes()[i] };
+        for (GLuint lod = 0; lod < lodSlots; lod++)
+        {
+            MeshLod range{ lod < mesh.lods.size() ? mesh.lods[lod] : MeshLod{} };
+            if (lodSlots == 1)
+                range = { draws[i].firstIndex, draws[i].count };
+            DrawElementsIndirectCommand& counter{ counters[i * lodSlots + lod] };
+            counter = draws[i];
+            counter.count = range.indexCount;
+            counter.firstIndex = range.firstIndex;
+            counter.instanceCount = 0;
+            counter.baseInstance += lod * static_cast<GLuint>(instances->count());
+            slots[i * lodSlots + lod] = range;
+        }
+        widest = std::max(widest, draws[i].instanceCount);
+    }
+    setupCullUniforms(*static_cast<CullUniforms*>(uniforms.data), viewProjection, pyramid, lodSlots > 1 ? lods.scale : 0.0f);
+
+    GLuint linked{ queue->program(program) };
+    if (linked != checkedProgram)
+    {
+        // Once per link, an edited Compute.glsl could have moved it
+        queue->reflection(program).checkLocation("lodSlots", lodSlotsLocation);
+        checkedProgram = linked;
+    }
+    glUseProgram(linked);
+    glUniform1ui(lodSlotsLocation, lodSlots);
+    glBindBufferRange(GL_UNIFORM_BUFFER, 1, ring.buffer(), uniforms.offset, uniforms.size);
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, ring.buffer(), source.offset, source.size);
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 1, ring.buffer(), culled.offset, culled.size);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, instances->bounds());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, instances->transforms());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, culledModels);
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 5, ring.buffer(), lodTable.offset, lodTable.size);
+    glDispatchCompute((widest + groupSize - 1) / groupSize, static_cast<GLuint>(draws.size()), 1);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+    glBindTextureUnit(1, 0);
+
+    drawBuffer = ring.buffer();
+    drawOffset = culled.offset;
+    drawCount = static_cast<GLsizei>(slotCount);
+    return true;
+}
+
+void CullingPass::draw(GLenum mode) const
+{
+    if (!drawCount)
+        return;
+
+    // Compacted matrices keep the draws' baseInstance, each draw only fills a prefix of its range
+    GLuint vao{ instances->vertexArray() };
+    glVertexArrayVertexBuffer(vao, InstanceBuffer::binding, culledModels, 0, sizeof(glm::mat4));
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, drawBuffer);
+    glMultiDrawElementsIndirect(mode, MeshPool::indexType, reinterpret_cast<const void*>(drawOffset), drawCount, 0);
+    glVertexArrayVertexBuffer(vao, InstanceBuffer::binding, instances->transforms(), 0, sizeof(glm::mat4));
+}
+
+std::vector<DrawElementsIndirectCommand> CullingPass::readDraws() const
+{
+    std::vector<DrawElementsIndirectCommand> draws(drawCount);
+    if (!draws.empty())
+        glGetNamedBufferSubData(drawBuffer, drawOffset, draws.size() * sizeof(DrawElementsIndirectCommand), draws.data());
+    return draws;
+}
+
+GLuint CullingPass::visibleInstances() const
+{
+    GLuint visible{};
+    for (const DrawElementsIndirectCommand& draw : readDraws())
+        visible += draw.instanceCount;
+    return visible;
+}
+
+uint64_t CullingPass::visibleTriangles() const
+{
+    uint64_t triangles{};
+    for (const DrawElementsIndirectCommand& draw : readDraws())
+        triangles += uint64_t(draw.count / 3) * draw.instanceCount;
+    return triangles;
+}
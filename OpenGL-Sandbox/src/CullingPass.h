@@ -0,0 +1,73 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "DepthPyramid.h"
+#include "DrawBatch.h"
+#include "InstanceBuffer.h"
+#include "MeshPool.h"
+#include "ProgramQueue.h"
+#include "RingBuffer.h"
+
+// res/shaders/Culling.glsl, std140
+struct CullUniforms
+{
+    glm::vec4 frustum[6]{};
+    glm::mat4 occlusionViewProjection{ 1.0f };
+    glm::vec4 pyramid{ 0.0f };
+    glm::vec4 camera{ 0.0f };
+    glm::vec4 lodSelection{ 0.0f };
+};
+
+// Frustum and camera of viewProjection, plus the pyramid when it is valid, which is then
+// bound to texture unit 1 for the dispatch. lodScale is LodSelector::scale, 0 keeps LOD 0.
+void setupCullUniforms(CullUniforms& uniforms, const glm::mat4& viewProjection, const DepthPyramid* pyramid, float lodScale = 0.0f);
+
+// GPU frustum and occlusion culling of a DrawBatch with res/shaders/Compute.glsl. cull() writes the
+// batch into the frame's ring twice, as read-only source draws and as a copy with zero
+// instances, then dispatches a workgroup row per draw. Surviving instances append their
+// model matrix to a GPU-only compacted stream and bump the copy's instance count, which
+// draw() then submits as one glMultiDrawElementsIndirect. The CPU cost does not depend
+// on how many instances there are.
+//
+// With LOD slots every draw turns into one draw per LOD of its mesh: a survivor picks its
+// LOD as LodSelector does and appends to that draw. Each slot compacts into its own copy
+// of the instance range, so the compacted stream is lodSlots times the instances.
+class CullingPass
+{
+public:
+    // The instances need bounds; the program compiles in the background, see ready().
+    // lodSlots is the most LODs a mesh of the batches has, 1 draws what the batch says.
+    bool init(ProgramQueue& programQueue, const InstanceBuffer& instanceBuffer, GLuint lodSlots = 1);
+    void shutdown();
+
+    bool ready() const { return queue && queue->ready(program); }
+
+    // Occlusion uses a pyramid of the previous frame, so an object that comes out from behind
+    // another shows up a frame late. Leaves the compute program bound, use the draw program before draw()
+    bool cull(RingBuffer& ring, const DrawBatch& batch, const glm::mat4& viewProjection, const DepthPyramid* pyramid = nullptr,
+              const LodSelector& lods = {});
+    void draw(GLenum mode = GL_TRIANGLES) const;
+
+    // Instances and triangles that survived the last cull(); reads back, so only for reports
+    GLuint visibleInstances() const;
+    uint64_t visibleTriangles() const;
+
+private:
+    std::vector<DrawElementsIndirectCommand> readDraws() const;
+
+    ProgramQueue*           queue{};
+    ProgramQueue::Handle    program{};
+    GLuint                  checkedProgram{};   // whose uniform locations were checked
+    const InstanceBuffer*   instances{};
+    GLuint                  lodSlots{ 1 };
+    GLuint                  culledModels{};
+    GLsizeiptr              storageAlignment{ 256 };
+    GLuint                  drawBuffer{};   // the ring of the last cull()
+    GLintptr                drawOffset{};
+    GLsizei                 drawCount{};
+};
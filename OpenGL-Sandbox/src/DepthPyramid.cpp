@@ -0,0 +1,89 @@
+#include "DepthPyramid.h"
+
+#include <algorithm>
+
+namespace
+{
+    const int tileTexels{ 32 }; // first level texels per workgroup and axis
+
+    // DepthPyramid.glsl's explicit uniform locations; SPIR-V programs can't be asked by name
+    const GLint sourceLevelLocation{ 0 };
+    const GLint levelCountLocation{ 1 };
+    const GLint fromDepthLocation{ 2 };
+
+    int nextPowerOfTwo(int value)
+    {
+        int power{ 1 };
+        while (power < value)
+            power *= 2;
+        return power;
+    }
+}
+
+bool DepthPyramid::init(ProgramQueue& programQueue, int depthWidth, int depthHeight)
+{
+    shutdown();
+
+    queue = &programQueue;
+    program = queue->submit(computeProgram("res/shaders/DepthPyramid.glsl"));
+
+    // Power of two, so every level is exactly half the one before and no edge texel is dropped;
+    // the padding repeats the last depth texels
+    size = glm::ivec2(depthWidth, depthHeight);
+    baseSize = glm::ivec2(nextPowerOfTwo((depthWidth + 1) / 2), nextPowerOfTwo((depthHeight + 1) / 2));
+    levelCount = 1;
+    while ((std::max(baseSize.x, baseSize.y) >> levelCount) > 0)
+        levelCount++;
+
+    glCreateTextures(GL_TEXTURE_2D, 1, &name);
+    glTextureStorage2D(name, levelCount, GL_RG32F, baseSize.x, baseSize.y);
+    glTextureParameteri(name, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTextureParameteri(name, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    return true;
+}
+
+void DepthPyramid::shutdown()
+{
+    if (name)
+        glDeleteTextures(1, &name);
+    name = 0;
+    queue = nullptr;
+    built = false;
+}
+
+bool DepthPyramid::build(GLuint depthTexture, const glm::mat4& viewProjection)
+{
+    if (!queue || !queue->ready(program))
+        return false;
+
+    GLuint linked{ queue->program(program) };
+    if (linked != checkedProgram)
+    {
+        // Once per link, an edited DepthPyramid.glsl could have moved them
+        const ProgramReflection& reflection{ queue->reflection(program) };
+        reflection.checkLocation("sourceLevel", sourceLevelLocation);
+        reflection.checkLocation("levelCount", levelCountLocation);
+        reflection.checkLocation("fromDepth", fromDepthLocation);
+        checkedProgram = linked;
+    }
+    glUseProgram(linked);
+    for (int first = 0; first < levelCount; first += levelsPerDispatch)
+    {
+        int count{ std::min(levelsPerDispatch, levelCount - first) };
+        glBindTextureUnit(0, first == 0 ? depthTexture : name);
+        glUniform1i(sourceLevelLocation, first == 0 ? 0 : first - 1);
+        glUniform1i(levelCountLocation, count);
+        glUniform1i(fromDepthLocation, first == 0 ? 1 : 0);
+        for (int i = 0; i < count; i++)
+            glBindImageTexture(i, name, first + i, GL_FALSE, 0, GL_WRITE_ONLY, GL_RG32F);
+
+        glm::ivec2 texels{ glm::max(baseSize >> first, glm::ivec2(1)) };
+        glDispatchCompute((texels.x + tileTexels - 1) / tileTexels, (texels.y + tileTexels - 1) / tileTexels, 1);
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    }
+    glBindTextureUnit(0, 0);
+
+    builtViewProjection = viewProjection;
+    built = true;
+    return true;
+}
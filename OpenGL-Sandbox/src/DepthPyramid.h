@@ -0,0 +1,40 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "ProgramQueue.h"
+
+// Hierarchical-Z: a min/max mip chain of the depth buffer, built by res/shaders/DepthPyramid.glsl
+// after the main pass. Level 0 is half the depth resolution rounded up to a power of two, every
+// texel holds the nearest (r) and farthest (g) depth of the 2x2 depth texels under it. One dispatch writes six levels through
+// shared memory, so the usual 1080p chain takes two dispatches.
+class DepthPyramid
+{
+public:
+    static const int levelsPerDispatch{ 6 };
+
+    bool init(ProgramQueue& programQueue, int depthWidth, int depthHeight);
+    void shutdown();
+
+    // depthTexture has to be depthWidth x depthHeight; false until the program is ready
+    bool build(GLuint depthTexture, const glm::mat4& viewProjection);
+
+    bool valid() const { return built; }
+    GLuint texture() const { return name; }
+    int levels() const { return levelCount; }
+    glm::ivec2 depthSize() const { return size; }
+    const glm::mat4& viewProjection() const { return builtViewProjection; }   // of the depth it holds
+
+private:
+    ProgramQueue*           queue{};
+    ProgramQueue::Handle    program{};
+    GLuint                  checkedProgram{};   // whose uniform locations were checked
+    GLuint                  name{};
+    glm::ivec2              size{};         // of the depth texture
+    glm::ivec2              baseSize{};     // of level 0
+    int                     levelCount{};
+    bool                    built{};
+    glm::mat4               builtViewProjection{ 1.0f };
+};
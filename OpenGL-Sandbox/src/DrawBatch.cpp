@@ -0,0 +1,63 @@
+#include "DrawBatch.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "MeshPool.h"
+#include "SoftwareRasterizer.h"
+
+void DrawBatch::clear()
+{
+    commands.clear();
+    sources.clear();
+}
+
+void DrawBatch::add(const MeshRange& mesh, GLuint firstInstance, GLuint instanceCount, size_t lod)
+{
+    if (mesh.lods.empty() || instanceCount == 0)
+        return;
+
+    const MeshLod& range{ mesh.lods[std::min(lod, mesh.lods.size() - 1)] };
+    if (!commands.empty())
+    {
+        DrawElementsIndirectCommand& last{ commands.back() };
+        if (last.firstIndex == range.firstIndex && last.count == range.indexCount && last.baseVertex == mesh.baseVertex &&
+            last.baseInstance + last.instanceCount == firstInstance)
+        {
+            last.instanceCount += instanceCount;
+            return;
+        }
+    }
+    commands.push_back({ range.indexCount, instanceCount, range.firstIndex, mesh.baseVertex, firstInstance });
+    sources.push_back(&mesh);
+}
+
+bool DrawBatch::submit(RingBuffer& ring, GLenum mode) const
+{
+    if (commands.empty())
+        return true;
+
+    GLsizeiptr size{ static_cast<GLsizeiptr>(commands.size() * sizeof(DrawElementsIndirectCommand)) };
+    RingBuffer::Allocation indirect{ ring.allocate(size, sizeof(GLuint)) };
+    if (!indirect)
+        return false;
+    memcpy(indirect.data, commands.data(), size);
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, ring.buffer());
+    glMultiDrawElementsIndirect(mode, MeshPool::indexType, reinterpret_cast<const void*>(indirect.offset),
+                                static_cast<GLsizei>(commands.size()), 0);
+    return true;
+}
+
+uint64_t DrawBatch::submit(SoftwareRasterizer& rasterizer, const glm::mat4& viewProjection, uint32_t color) const
+{
+    return rasterizer.draw(commands.data(), commands.size(), viewProjection, color);
+}
+
+uint64_t DrawBatch::triangleCount() const
+{
+    uint64_t triangles{};
+    for (const DrawElementsIndirectCommand& command : commands)
+        triangles += uint64_t(command.count / 3) * command.instanceCount;
+    return triangles;
+}
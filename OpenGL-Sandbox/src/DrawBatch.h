@@ -0,0 +1,48 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "RingBuffer.h"
+
+struct MeshRange;
+class SoftwareRasterizer;
+
+// glMultiDrawElementsIndirect record, layout fixed by GL
+struct DrawElementsIndirectCommand
+{
+    GLuint  count{};
+    GLuint  instanceCount{};
+    GLuint  firstIndex{};
+    GLint   baseVertex{};
+    GLuint  baseInstance{};     // first model matrix of the draw, see InstanceBuffer.h
+};
+
+// Gathers the draws of a pass and submits them with one glMultiDrawElementsIndirect, so the
+// CPU cost per object is writing 20 bytes instead of a draw call. The commands go through the
+// frame's RingBuffer; a run of instances that continues the previous draw of the same mesh
+// is merged into that draw.
+class DrawBatch
+{
+public:
+    void clear();
+    void add(const MeshRange& mesh, GLuint firstInstance, GLuint instanceCount, size_t lod = 0);
+
+    // Draws with the MeshPool's vertex array bound; false when the ring had no room
+    bool submit(RingBuffer& ring, GLenum mode = GL_TRIANGLES) const;
+    // The same draws on the CPU backend, returns the triangles it rasterized
+    uint64_t submit(SoftwareRasterizer& rasterizer, const glm::mat4& viewProjection, uint32_t color) const;
+
+    const std::vector<DrawElementsIndirectCommand>& draws() const { return commands; }
+    const std::vector<const MeshRange*>& meshes() const { return sources; }    // per draw, for passes that pick LODs
+    size_t drawCount() const { return commands.size(); }
+    uint64_t triangleCount() const;
+
+private:
+    std::vector<DrawElementsIndirectCommand> commands{};
+    std::vector<const MeshRange*> sources{};
+};
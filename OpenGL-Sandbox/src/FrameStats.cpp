@@ -0,0 +1,114 @@
+#include "FrameStats.h"
+
+#include <algorithm>
+#include <fstream>
+
+namespace
+{
+    struct Summary
+    {
+        double min{}, avg{}, median{}, p95{}, max{};
+    };
+
+    Summary summarize(std::vector<double> samples)
+    {
+        Summary s{};
+        if (samples.empty())
+            return s;
+
+        std::sort(samples.begin(), samples.end());
+        double sum{};
+        for (double v : samples)
+            sum += v;
+
+        s.min = samples.front();
+        s.max = samples.back();
+        s.avg = sum / samples.size();
+        s.median = samples[samples.size() / 2];
+        s.p95 = samples[std::min(samples.size() - 1, samples.size() * 95 / 100)];
+        return s;
+    }
+}
+
+void FrameStats::init(int expectedFrames, bool gpuTimers)
+{
+    gpuTimed = gpuTimers;
+    if (gpuTimed)
+        glGenQueries(2, queries);
+    cpuMs.clear();
+    gpuMs.clear();
+    if (expectedFrames > 0)
+    {
+        cpuMs.reserve(expectedFrames);
+        gpuMs.reserve(expectedFrames);
+    }
+}
+
+void FrameStats::shutdown()
+{
+    if (gpuTimed)
+        glDeleteQueries(2, queries);
+    queries[0] = queries[1] = 0;
+}
+
+void FrameStats::beginFrame()
+{
+    frameStart = Clock::now();
+    if (gpuTimed)
+        glQueryCounter(queries[0], GL_TIMESTAMP);
+}
+
+void FrameStats::endFrame()
+{
+    if (!gpuTimed)
+    {
+        std::chrono::duration<double, std::milli> cpu{ Clock::now() - frameStart };
+        cpuMs.push_back(cpu.count());
+        gpuMs.push_back(0.0);
+        return;
+    }
+
+    glQueryCounter(queries[1], GL_TIMESTAMP);
+    glFinish();
+
+    GLuint64 start{}, end{};
+    glGetQueryObjectui64v(queries[0], GL_QUERY_RESULT, &start); // ready after glFinish, does not block
+    glGetQueryObjectui64v(queries[1], GL_QUERY_RESULT, &end);
+
+    std::chrono::duration<double, std::milli> cpu{ Clock::now() - frameStart };
+    cpuMs.push_back(cpu.count());
+    gpuMs.push_back(end > start ? (end - start) / 1.0e6 : 0.0);
+}
+
+void FrameStats::report(FILE* out) const
+{
+    Summary cpu{ summarize(cpuMs) };
+    Summary gpu{ summarize(gpuMs) };
+
+    fprintf(out, "frames: %zu\n", cpuMs.size());
+    fprintf(out, "        %10s %10s %10s %10s %10s\n", "min", "avg", "median", "p95", "max");
+    fprintf(out, "cpu ms  %10.3f %10.3f %10.3f %10.3f %10.3f\n", cpu.min, cpu.avg, cpu.median, cpu.p95, cpu.max);
+    if (gpuTimed)
+        fprintf(out, "gpu ms  %10.3f %10.3f %10.3f %10.3f %10.3f\n", gpu.min, gpu.avg, gpu.median, gpu.p95, gpu.max);
+    if (cpu.avg > 0.0)
+        fprintf(out, "fps     %10.1f (from average cpu frame time)\n", 1000.0 / cpu.avg);
+    if (triangles > 0.0 && gpu.avg > 0.0)
+        fprintf(out, "Mtris/s %10.1f (%.0f triangles per frame, from average gpu frame time)\n", triangles / (gpu.avg * 1000.0), triangles);
+    else if (triangles > 0.0 && !gpuTimed && cpu.avg > 0.0)
+        fprintf(out, "Mtris/s %10.1f (%.0f triangles per frame, from average cpu frame time)\n", triangles / (cpu.avg * 1000.0), triangles);
+}
+
+bool FrameStats::writeCsv(const std::string& path) const
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        fprintf(stderr, "Can't write frame stats to %s\n", path.c_str());
+        return false;
+    }
+
+    file << "frame,cpu_ms,gpu_ms\n";
+    for (size_t i = 0; i < cpuMs.size(); i++)
+        file << i << ',' << cpuMs[i] << ',' << gpuMs[i] << '\n';
+    return true;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Collects CPU and GPU time of every frame and prints a summary at exit.
+// GPU time comes from a pair of GL_TIMESTAMP queries, so beginFrame()/endFrame()
+// have to be called with the context current; without gpuTimers there is no GL at all
+// and the throughput comes from the CPU time.
+class FrameStats
+{
+public:
+    void init(int expectedFrames = 0, bool gpuTimers = true);
+    void shutdown();
+
+    void beginFrame();
+    void endFrame(); // waits for the GPU, call only when stalls are acceptable (headless runs)
+
+    // Triangles submitted per frame, report() adds the throughput they imply
+    void setWorkload(double trianglesPerFrame) { triangles = trianglesPerFrame; }
+
+    void report(FILE* out) const;
+    bool writeCsv(const std::string& path) const;
+
+    size_t frameCount() const { return cpuMs.size(); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    GLuint              queries[2]{}; // frame start / end timestamps
+    Clock::time_point   frameStart{};
+    std::vector<double> cpuMs{};
+    std::vector<double> gpuMs{};
+    double              triangles{};
+    bool                gpuTimed{ true };
+};
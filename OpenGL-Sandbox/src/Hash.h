@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// 64-bit FNV-1a. Good enough for cache keys and dedup tables, not for security.
+const uint64_t hashSeed{ 14695981039346656037ull };
+
+inline uint64_t hashBytes(const void* data, size_t size, uint64_t hash = hashSeed)
+{
+    const unsigned char* bytes{ static_cast<const unsigned char*>(data) };
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// Length first, so ("ab", "c") and ("a", "bc") don't collide when chained
+inline uint64_t hashBlock(const void* data, size_t size, uint64_t hash = hashSeed)
+{
+    uint64_t length{ size };
+    hash = hashBytes(&length, sizeof(length), hash);
+    return hashBytes(data, size, hash);
+}
+
+inline uint64_t hashString(const std::string& string, uint64_t hash = hashSeed)
+{
+    return hashBlock(string.data(), string.size(), hash);
+}
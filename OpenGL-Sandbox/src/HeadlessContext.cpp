@@ -0,0 +1,109 @@
+#include "HeadlessContext.h"
+
+#include <cstdio>
+
+#ifdef _WIN32
+
+#include <GLFW/glfw3.h>
+
+bool HeadlessContext::create(int majorVersion, int minorVersion)
+{
+    if (!glfwInit())
+        return false;
+
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, majorVersion);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, minorVersion);
+    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE);
+
+    window = glfwCreateWindow(1, 1, "headless", NULL, NULL);
+    if (!window)
+    {
+        fprintf(stderr, "Hidden window creation error\n");
+        glfwTerminate();
+        return false;
+    }
+    glfwMakeContextCurrent(window);
+    return true;
+}
+
+void HeadlessContext::destroy()
+{
+    if (window)
+        glfwDestroyWindow(window);
+    window = nullptr;
+    glfwTerminate();
+}
+
+#else
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+bool HeadlessContext::create(int majorVersion, int minorVersion)
+{
+    EGLDisplay eglDisplay{ EGL_NO_DISPLAY };
+
+    // Surfaceless platform first, it needs neither a window system nor a DRM device
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay{
+        reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT")) };
+    if (getPlatformDisplay)
+        eglDisplay = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    if (eglDisplay == EGL_NO_DISPLAY)
+        eglDisplay = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+    EGLint major{}, minor{};
+    if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, &major, &minor))
+    {
+        fprintf(stderr, "EGL initialization error\n");
+        return false;
+    }
+    if (!eglBindAPI(EGL_OPENGL_API))
+    {
+        fprintf(stderr, "EGL has no desktop OpenGL support\n");
+        eglTerminate(eglDisplay);
+        return false;
+    }
+
+    const EGLint contextAttribs[] =
+    {
+        EGL_CONTEXT_MAJOR_VERSION,          majorVersion,
+        EGL_CONTEXT_MINOR_VERSION,          minorVersion,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK,    EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_CONTEXT_OPENGL_DEBUG,           EGL_TRUE,
+        EGL_NONE
+    };
+    // EGL_KHR_no_config_context + EGL_KHR_surfaceless_context: no config, no surface
+    EGLContext eglContext{ eglCreateContext(eglDisplay, EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, contextAttribs) };
+    if (eglContext == EGL_NO_CONTEXT)
+    {
+        fprintf(stderr, "EGL context creation error (0x%x)\n", eglGetError());
+        eglTerminate(eglDisplay);
+        return false;
+    }
+    if (!eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, eglContext))
+    {
+        fprintf(stderr, "EGL surfaceless make current error (0x%x)\n", eglGetError());
+        eglDestroyContext(eglDisplay, eglContext);
+        eglTerminate(eglDisplay);
+        return false;
+    }
+
+    display = eglDisplay;
+    context = eglContext;
+    return true;
+}
+
+void HeadlessContext::destroy()
+{
+    if (!display)
+        return;
+
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroyContext(display, context);
+    eglTerminate(display);
+    display = nullptr;
+    context = nullptr;
+}
+
+#endif
@@ -0,0 +1,26 @@
+#pragma once
+
+struct GLFWwindow;
+
+// OpenGL context without a visible window, for perf boxes with no display.
+// On Windows this is a hidden GLFW window, whose default framebuffer exists
+// but has undefined contents while it is not shown. Everywhere else it is an
+// EGL surfaceless context (EGL_MESA_platform_surfaceless), which Mesa llvmpipe
+// provides without X11 or a GPU, and which has no default framebuffer at all.
+// Either way headless runs render into an FBO. The stock GLX build of GLEW
+// works under EGL: glewInit() loads every entry point and only reports
+// GLEW_ERROR_NO_GLX_DISPLAY, which the caller ignores.
+class HeadlessContext
+{
+public:
+    bool create(int majorVersion, int minorVersion);
+    void destroy();
+
+private:
+#ifdef _WIN32
+    GLFWwindow*     window = nullptr;
+#else
+    void*           display = nullptr; // EGLDisplay
+    void*           context = nullptr; // EGLContext
+#endif
+};
@@ -0,0 +1,82 @@
+#include "InstanceBuffer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+bool InstanceBuffer::init(GLuint vertexArray, const std::vector<glm::mat4>& models, const std::vector<glm::vec4>& spheres)
+{
+    shutdown();
+    if (models.empty())
+    {
+        fprintf(stderr, "No instances to upload\n");
+        return false;
+    }
+
+    vao = vertexArray;
+    instances = static_cast<GLsizei>(models.size());
+    glCreateBuffers(1, &name);
+    glNamedBufferStorage(name, models.size() * sizeof(glm::mat4), models.data(), 0);
+    if (spheres.size() == models.size())
+    {
+        glCreateBuffers(1, &boundsName);
+        glNamedBufferStorage(boundsName, spheres.size() * sizeof(glm::vec4), spheres.data(), 0);
+    }
+
+    // A mat4 attribute takes one location per column
+    glVertexArrayVertexBuffer(vao, binding, name, 0, sizeof(glm::mat4));
+    glVertexArrayBindingDivisor(vao, binding, 1);
+    for (GLuint column = 0; column < 4; column++)
+    {
+        glVertexArrayAttribFormat(vao, location + column, 4, GL_FLOAT, GL_FALSE, column * sizeof(glm::vec4));
+        glVertexArrayAttribBinding(vao, location + column, binding);
+        glEnableVertexArrayAttrib(vao, location + column);
+    }
+    return true;
+}
+
+void InstanceBuffer::shutdown()
+{
+    if (vao)
+    {
+        for (GLuint column = 0; column < 4; column++)
+            glDisableVertexArrayAttrib(vao, location + column);
+        glVertexArrayVertexBuffer(vao, binding, 0, 0, sizeof(glm::mat4));
+    }
+    if (name)
+        glDeleteBuffers(1, &name);
+    if (boundsName)
+        glDeleteBuffers(1, &boundsName);
+    vao = 0;
+    name = 0;
+    boundsName = 0;
+    instances = 0;
+}
+
+glm::vec4 transformSphere(const glm::mat4& model, const glm::vec4& sphere)
+{
+    glm::vec3 center{ model * glm::vec4(glm::vec3(sphere), 1.0f) };
+    float scale{ std::max(glm::length(glm::vec3(model[0])),
+                 std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2])))) };
+    return glm::vec4(center, sphere.w * scale);
+}
+
+std::vector<glm::mat4> instanceGrid(int count, float spacing)
+{
+    std::vector<glm::mat4> models{};
+    if (count <= 0)
+        return models;
+
+    int side{ static_cast<int>(std::ceil(std::cbrt(static_cast<double>(count)))) };
+    float start{ -0.5f * spacing * (side - 1) };
+    models.reserve(count);
+    for (int i = 0; i < count; i++)
+    {
+        glm::mat4 model{ 1.0f };
+        model[3] = glm::vec4(start + spacing * (i % side),
+                             start + spacing * (i / side % side),
+                             start + spacing * (i / (side * side)), 1.0f);
+        models.push_back(model);
+    }
+    return models;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+// Per-instance model matrices for instanced draws. They are a mat4 vertex attribute
+// (locations 4-7, see Vertex.glsl) on their own VAO binding with a divisor of 1, so a
+// draw's baseInstance offsets into them like it does for any other vertex stream.
+// Optional world space bounding spheres, one per instance, are what GPU culling tests.
+class InstanceBuffer
+{
+public:
+    static const GLuint binding{ 1 };
+    static const GLuint location{ 4 };
+
+    // Immutable storage; the VAO's binding points at it until shutdown()
+    bool init(GLuint vao, const std::vector<glm::mat4>& models, const std::vector<glm::vec4>& spheres = {});
+    void shutdown();
+
+    GLsizei count() const { return instances; }
+    GLuint vertexArray() const { return vao; }
+    GLuint transforms() const { return name; }
+    GLuint bounds() const { return boundsName; }    // 0 without spheres
+
+private:
+    GLuint  vao{};
+    GLuint  name{};
+    GLuint  boundsName{};
+    GLsizei instances{};
+};
+
+// Bounding sphere (xyz center, w radius) moved by a model matrix, grown by its largest scale
+glm::vec4 transformSphere(const glm::mat4& model, const glm::vec4& sphere);
+
+// count transforms on a cube of cells spacing apart, centered on the origin
+std::vector<glm::mat4> instanceGrid(int count, float spacing);
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file. The bytes are not null-terminated,
+// always pass data() together with size().
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept { swap(other); }
+    MappedFile& operator=(MappedFile&& other) noexcept { close(); swap(other); return *this; }
+
+    bool open(const std::string& path); // false if the file is missing or can't be mapped
+    void close();
+
+    bool isOpen() const { return opened; }
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    void swap(MappedFile& other) noexcept;
+
+    const char* bytes{};
+    size_t      length{};
+    bool        opened{};
+#ifdef _WIN32
+    void*       fileHandle{};
+    void*       mappingHandle{};
+#endif
+};
@@ -0,0 +1,73 @@
+#include "MeshBuilder.h"
+#include "Hash.h"
+
+#include <cstring>
+
+GLenum Mesh::indexType() const
+{
+    return vertexCount() <= 0x10000 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+size_t Mesh::indexSize() const
+{
+    return indexType() == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
+std::vector<uint8_t> Mesh::indexData() const
+{
+    std::vector<uint8_t> data(indices.size() * indexSize());
+    if (indexType() == GL_UNSIGNED_INT)
+    {
+        memcpy(data.data(), indices.data(), data.size());
+        return data;
+    }
+
+    uint16_t* narrow{ reinterpret_cast<uint16_t*>(data.data()) };
+    for (size_t i = 0; i < indices.size(); i++)
+        narrow[i] = static_cast<uint16_t>(indices[i]);
+    return data;
+}
+
+MeshBuilder::MeshBuilder(int floatsPerVertex)
+{
+    result.stride = floatsPerVertex;
+    scratch.resize(floatsPerVertex);
+}
+
+uint32_t MeshBuilder::addVertex(const float* vertex)
+{
+    // +0.0f turns -0.0f into 0.0f: equal values, different bits
+    int stride{ result.stride };
+    for (int i = 0; i < stride; i++)
+        scratch[i] = vertex[i] + 0.0f;
+    const float* key{ scratch.data() };
+    size_t bytes{ stride * sizeof(float) };
+
+    uint64_t hash{ hashBytes(key, bytes) };
+    auto range = lookup.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it)
+        if (memcmp(&result.vertices[it->second * stride], key, bytes) == 0)
+            return it->second;
+
+    uint32_t index{ static_cast<uint32_t>(result.vertexCount()) };
+    result.vertices.insert(result.vertices.end(), key, key + stride);
+    lookup.emplace(hash, index);
+    return index;
+}
+
+void MeshBuilder::addTriangles(const float* soup, size_t vertexCount)
+{
+    result.indices.reserve(result.indices.size() + vertexCount);
+    lookup.reserve(lookup.size() + vertexCount);
+    for (size_t i = 0; i < vertexCount; i++)
+        result.indices.push_back(addVertex(soup + i * result.stride));
+}
+
+Mesh MeshBuilder::take()
+{
+    Mesh mesh{ std::move(result) };
+    result = Mesh{};
+    result.stride = mesh.stride;
+    lookup.clear();
+    return mesh;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Indexed triangle list, every vertex is `stride` floats and is stored once
+struct Mesh
+{
+    int                     stride{ 3 };    // floats per vertex
+    std::vector<float>      vertices{};
+    std::vector<uint32_t>   indices{};      // 3 per triangle
+
+    size_t vertexCount() const { return vertices.size() / stride; }
+
+    // GL_UNSIGNED_SHORT while every index fits, half the index memory and fetch
+    GLenum indexType() const;
+    size_t indexSize() const;               // bytes per index of indexType()
+    std::vector<uint8_t> indexData() const; // indices packed as indexType(), ready for glBufferData
+};
+
+// Welds a triangle soup: bit-identical vertices share one index. Lookup goes through
+// a hash of the vertex bytes, so building is linear in the number of input vertices.
+class MeshBuilder
+{
+public:
+    explicit MeshBuilder(int floatsPerVertex = 3);
+
+    uint32_t addVertex(const float* vertex);                    // index of the existing copy if any
+    void addTriangles(const float* soup, size_t vertexCount);   // 3 consecutive vertices per triangle
+
+    const Mesh& mesh() const { return result; }
+    Mesh take();                                                // hands the mesh out and starts over
+
+private:
+    Mesh result{};
+    std::unordered_multimap<uint64_t, uint32_t> lookup{};       // vertex hash -> index
+    std::vector<float> scratch{};
+};
@@ -0,0 +1,183 @@
+#include "MeshFile.h"
+#include "MeshBuilder.h"
+#include "VertexFormat.h"
+
+#include <GL/glew.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <glm/glm.hpp>
+
+namespace
+{
+    uint64_t alignUp(uint64_t offset, uint64_t alignment)
+    {
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+
+    size_t typeSize(uint32_t type)
+    {
+        switch (type)
+        {
+        case GL_BYTE: case GL_UNSIGNED_BYTE:    return 1;
+        case GL_SHORT: case GL_UNSIGNED_SHORT: case GL_HALF_FLOAT: return 2;
+        default:                                return 4;
+        }
+    }
+}
+
+std::vector<char> MeshFile::pack(const Mesh& mesh, const PackedVertices& vertices,
+                                 const std::vector<std::vector<uint32_t>>& lods, const std::vector<float>& lodErrors,
+                                 const std::vector<Meshlet>& meshlets)
+{
+    MeshFileHeader header{};
+    header.magic = magic;
+    header.version = version;
+    header.vertexCount = static_cast<uint32_t>(mesh.vertexCount());
+    header.vertexStride = vertices.stride;
+    header.indexType = mesh.indexType();
+    header.attributeCount = static_cast<uint32_t>(vertices.attributes.size());
+    for (int i = 0; i < 3; i++)
+    {
+        header.positionOffset[i] = vertices.positionOffset[i];
+        header.positionScale[i] = vertices.positionScale[i];
+    }
+
+    std::vector<MeshLod> lodTable{ { 0, static_cast<uint32_t>(mesh.indices.size()), 0.0f } };
+    std::vector<uint32_t> indices{ mesh.indices };
+    for (size_t i = 0; i < lods.size(); i++)
+    {
+        lodTable.push_back({ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(lods[i].size()),
+                             i < lodErrors.size() ? lodErrors[i] : 0.0f });
+        indices.insert(indices.end(), lods[i].begin(), lods[i].end());
+    }
+    header.lodCount = static_cast<uint32_t>(lodTable.size());
+    header.meshletCount = static_cast<uint32_t>(meshlets.size());
+    header.indexCount = static_cast<uint32_t>(indices.size());
+
+    // Bounds from the first 3 floats, the position
+    glm::vec3 low{ 0.0f }, high{ 0.0f };
+    for (size_t v = 0; v < mesh.vertexCount() && mesh.stride >= 3; v++)
+    {
+        glm::vec3 position{ mesh.vertices[v * mesh.stride], mesh.vertices[v * mesh.stride + 1], mesh.vertices[v * mesh.stride + 2] };
+        low = v ? glm::min(low, position) : position;
+        high = v ? glm::max(high, position) : position;
+    }
+    glm::vec3 center{ (low + high) * 0.5f };
+    for (size_t v = 0; v < mesh.vertexCount() && mesh.stride >= 3; v++)
+    {
+        glm::vec3 position{ mesh.vertices[v * mesh.stride], mesh.vertices[v * mesh.stride + 1], mesh.vertices[v * mesh.stride + 2] };
+        header.radius = std::max(header.radius, glm::length(position - center));
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        header.boundsMin[i] = low[i];
+        header.boundsMax[i] = high[i];
+        header.center[i] = center[i];
+    }
+
+    // Every LOD indexes the same vertices, so they share the mesh's index type
+    bool narrow{ header.indexType == GL_UNSIGNED_SHORT };
+    std::vector<char> indexBytes(indices.size() * (narrow ? sizeof(uint16_t) : sizeof(uint32_t)));
+    for (size_t i = 0; i < indices.size(); i++)
+    {
+        if (narrow)
+            reinterpret_cast<uint16_t*>(indexBytes.data())[i] = static_cast<uint16_t>(indices[i]);
+        else
+            reinterpret_cast<uint32_t*>(indexBytes.data())[i] = indices[i];
+    }
+
+    header.attributesOffset = sizeof(MeshFileHeader);
+    header.lodsOffset = header.attributesOffset + vertices.attributes.size() * sizeof(MeshAttribute);
+    header.meshletsOffset = header.lodsOffset + lodTable.size() * sizeof(MeshLod);
+    header.vertexOffset = alignUp(header.meshletsOffset + meshlets.size() * sizeof(Meshlet), streamAlignment);
+    header.indexOffset = alignUp(header.vertexOffset + vertices.data.size(), streamAlignment);
+
+    std::vector<char> image(static_cast<size_t>(header.indexOffset + indexBytes.size()), 0);
+    memcpy(image.data(), &header, sizeof(header));
+    memcpy(image.data() + header.attributesOffset, vertices.attributes.data(), vertices.attributes.size() * sizeof(MeshAttribute));
+    memcpy(image.data() + header.lodsOffset, lodTable.data(), lodTable.size() * sizeof(MeshLod));
+    memcpy(image.data() + header.meshletsOffset, meshlets.data(), meshlets.size() * sizeof(Meshlet));
+    memcpy(image.data() + header.vertexOffset, vertices.data.data(), vertices.data.size());
+    memcpy(image.data() + header.indexOffset, indexBytes.data(), indexBytes.size());
+    return image;
+}
+
+bool MeshFile::write(const std::string& path, const std::vector<char>& image)
+{
+    // Temp file + rename, a reader never maps a half written mesh
+    std::string temp{ path + ".tmp" };
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        file.write(image.data(), image.size());
+        if (!file)
+            return false;
+    }
+    std::remove(path.c_str());
+    return std::rename(temp.c_str(), path.c_str()) == 0;
+}
+
+bool MeshFile::open(const std::string& path)
+{
+    close();
+    if (!file.open(path))
+        return false;
+    if (validate())
+        return true;
+
+    fprintf(stderr, "%s is not a version %u mesh file\n", path.c_str(), version);
+    close();
+    return false;
+}
+
+bool MeshFile::open(std::vector<char> image)
+{
+    close();
+    memory = std::move(image);
+    if (validate())
+        return true;
+    close();
+    return false;
+}
+
+void MeshFile::close()
+{
+    file.close();
+    memory.clear();
+}
+
+size_t MeshFile::indexSize() const
+{
+    return size_t(header().indexCount) * (header().indexType == GL_UNSIGNED_SHORT ? 2 : 4);
+}
+
+// Only the tables are checked, the GPU is all that reads the streams as they are. CPU paths
+// go through fetchIndices(), which checks every index against the vertex count.
+bool MeshFile::validate()
+{
+    if (size() < sizeof(MeshFileHeader))
+        return false;
+
+    const MeshFileHeader& h{ header() };
+    if (h.magic != magic || h.version != version || !h.lodCount ||
+        (h.indexType != GL_UNSIGNED_SHORT && h.indexType != GL_UNSIGNED_INT))
+        return false;
+    if (h.attributesOffset + uint64_t(h.attributeCount) * sizeof(MeshAttribute) > size() ||
+        h.lodsOffset + uint64_t(h.lodCount) * sizeof(MeshLod) > size() ||
+        h.meshletsOffset + uint64_t(h.meshletCount) * sizeof(Meshlet) > size() ||
+        h.vertexOffset + vertexSize() > size() || h.indexOffset + indexSize() > size())
+        return false;
+
+    for (uint32_t i = 0; i < h.attributeCount; i++)
+        if (attributes()[i].offset + attributes()[i].components * typeSize(attributes()[i].type) > h.vertexStride)
+            return false;
+    for (uint32_t i = 0; i < h.lodCount; i++)
+        if (uint64_t(lods()[i].firstIndex) + lods()[i].indexCount > h.indexCount)
+            return false;
+    for (uint32_t i = 0; i < h.meshletCount; i++)
+        if (uint64_t(meshlets()[i].firstIndex) + meshlets()[i].indexCount > lods()[0].indexCount)
+            return false;
+    return true;
+}
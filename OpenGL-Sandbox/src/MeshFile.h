@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+
+struct Mesh;
+struct PackedVertices;
+
+// Binary mesh container, laid out so the mapped file is handed to GL as is:
+// header, attribute table, LOD table, meshlet table, then the vertex and index streams, each
+// stream starting on a streamAlignment boundary. All offsets are from the file start.
+struct MeshFileHeader
+{
+    uint32_t magic{};
+    uint32_t version{};
+    uint32_t vertexCount{};
+    uint32_t vertexStride{};        // bytes
+    uint32_t indexCount{};          // all LODs together
+    uint32_t indexType{};           // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    uint32_t attributeCount{};
+    uint32_t lodCount{};
+    uint32_t meshletCount{};        // 0 when the mesh was not split
+    uint32_t reserved{};
+    float    boundsMin[3]{};
+    float    boundsMax[3]{};
+    float    center[3]{};           // bounding sphere
+    float    radius{};
+    float    positionOffset[3]{};   // decode of quantized positions: offset + fetched * scale
+    float    positionScale[3]{};
+    uint64_t attributesOffset{};
+    uint64_t lodsOffset{};
+    uint64_t meshletsOffset{};
+    uint64_t vertexOffset{};
+    uint64_t indexOffset{};
+};
+
+// glVertexAttribFormat arguments of one attribute
+struct MeshAttribute
+{
+    uint32_t location{};
+    uint32_t components{};
+    uint32_t type{};                // GL_FLOAT, GL_SHORT, ...
+    uint32_t normalized{};
+    uint32_t offset{};              // bytes into the vertex
+    uint32_t reserved{};
+};
+
+// One level of detail: a range of the shared index stream, finest first
+struct MeshLod
+{
+    uint32_t firstIndex{};
+    uint32_t indexCount{};
+    float    error{};               // relative to the mesh radius, 0 for the full mesh
+    uint32_t reserved{};
+};
+
+// A cluster of LOD 0, a run of the index stream, with the bounds GPU cluster culling tests.
+// Laid out as three vec4s so the table goes into an SSBO unchanged, see buildMeshlets().
+struct Meshlet
+{
+    float    center[3]{};           // bounding sphere
+    float    radius{};
+    float    coneAxis[3]{};         // average face normal
+    float    coneCutoff{};          // backfacing from everywhere that sees it under less than this sine, 1 never
+    uint32_t firstIndex{};
+    uint32_t indexCount{};
+    uint32_t vertexCount{};         // unique vertices, at most the limit it was built with
+    uint32_t reserved{};
+};
+
+class MeshFile
+{
+public:
+    static const uint32_t magic{ 0x4853454D };  // "MESH"
+    static const uint32_t version{ 3 };
+    static const uint32_t streamAlignment{ 64 };
+
+    // File image of a mesh whose vertices were encoded by packVertices(); bounds come from the
+    // mesh's first 3 floats. lods are extra index lists over the same vertices, meshlets
+    // split the mesh's own indices.
+    static std::vector<char> pack(const Mesh& mesh, const PackedVertices& vertices,
+                                  const std::vector<std::vector<uint32_t>>& lods = {}, const std::vector<float>& lodErrors = {},
+                                  const std::vector<Meshlet>& meshlets = {});
+    static bool write(const std::string& path, const std::vector<char>& image);
+
+    bool open(const std::string& path);         // maps the file, only the header tables are checked
+    bool open(std::vector<char> image);         // same, over a packed image kept in memory
+    void close();
+
+    bool isOpen() const { return size() > 0; }
+    const MeshFileHeader& header() const { return *reinterpret_cast<const MeshFileHeader*>(data()); }
+    const MeshAttribute* attributes() const { return reinterpret_cast<const MeshAttribute*>(data() + header().attributesOffset); }
+    const MeshLod* lods() const { return reinterpret_cast<const MeshLod*>(data() + header().lodsOffset); }
+    const Meshlet* meshlets() const { return reinterpret_cast<const Meshlet*>(data() + header().meshletsOffset); }
+
+    const char* vertexData() const { return data() + header().vertexOffset; }
+    size_t vertexSize() const { return size_t(header().vertexCount) * header().vertexStride; }
+    const char* indexData() const { return data() + header().indexOffset; }
+    size_t indexSize() const;                   // bytes of the whole index stream
+
+private:
+    bool validate();
+    const char* data() const { return file.isOpen() ? file.data() : memory.data(); }
+    size_t size() const { return file.isOpen() ? file.size() : memory.size(); }
+
+    MappedFile          file{};
+    std::vector<char>   memory{};
+};
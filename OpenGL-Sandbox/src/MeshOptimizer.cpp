@@ -0,0 +1,806 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
+
+#include <glm/glm.hpp>
+
+VertexCacheStats analyzeVertexCache(const Mesh& mesh, unsigned cacheSize)
+{
+    VertexCacheStats stats{};
+    size_t triangleCount{ mesh.indices.size() / 3 };
+    if (!triangleCount)
+        return stats;
+
+    // Timestamp FIFO: a vertex is cached while fewer than cacheSize misses came after it
+    std::vector<size_t> missedAt(mesh.vertexCount(), 0);
+    std::vector<bool> used(mesh.vertexCount(), false);
+    size_t misses{}, unique{};
+    for (uint32_t index : mesh.indices)
+    {
+        if (!used[index])
+        {
+            used[index] = true;
+            unique++;
+        }
+        if (missedAt[index] == 0 || misses - missedAt[index] >= cacheSize)
+            missedAt[index] = ++misses;
+    }
+    stats.acmr = static_cast<float>(misses) / triangleCount;
+    stats.atvr = static_cast<float>(misses) / unique;
+    return stats;
+}
+
+namespace
+{
+    const int forsythCacheSize{ 32 };
+
+    float vertexScore(int cachePosition, unsigned remaining)
+    {
+        if (remaining == 0)
+            return -1.0f; // nothing left to draw with it
+
+        float score{};
+        if (cachePosition >= 0)
+        {
+            if (cachePosition < 3)
+                score = 0.75f; // the last triangle's vertices, deliberately below the next ones
+            else
+                score = std::pow(1.0f - (cachePosition - 3) / float(forsythCacheSize - 3), 1.5f);
+        }
+        return score + 2.0f / std::sqrt(static_cast<float>(remaining));
+    }
+}
+
+void optimizeVertexCache(Mesh& mesh)
+{
+    optimizeVertexCache(mesh.indices, mesh.vertexCount());
+}
+
+void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount)
+{
+    size_t triangleCount{ indices.size() / 3 };
+    if (triangleCount < 2)
+        return;
+
+    // Triangles of every vertex, compacted: the first `remaining` of each list are not emitted yet
+    std::vector<unsigned> remaining(vertexCount, 0);
+    for (uint32_t index : indices)
+        remaining[index]++;
+    std::vector<size_t> firstTriangle(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++)
+        firstTriangle[v + 1] = firstTriangle[v] + remaining[v];
+    std::vector<uint32_t> adjacency(indices.size());
+    {
+        std::vector<size_t> cursor(firstTriangle.begin(), firstTriangle.end() - 1);
+        for (size_t i = 0; i < indices.size(); i++)
+            adjacency[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> score(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++)
+        score[v] = vertexScore(-1, remaining[v]);
+    std::vector<float> triangleScore(triangleCount);
+    for (size_t t = 0; t < triangleCount; t++)
+        triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<uint32_t> output{};
+    output.reserve(indices.size());
+    std::vector<uint32_t> cache{}, nextCache{};
+    size_t scanCursor{};
+
+    int best{ -1 };
+    while (output.size() < indices.size())
+    {
+        if (best < 0)
+        {
+            // Cache ran dry (disconnected part): continue with the next triangle in input order
+            while (emitted[scanCursor])
+                scanCursor++;
+            best = static_cast<int>(scanCursor);
+        }
+
+        const uint32_t* triangle{ &indices[best * 3] };
+        emitted[best] = true;
+        output.insert(output.end(), triangle, triangle + 3);
+
+        // Drop the triangle from its vertices' pending lists
+        for (int k = 0; k < 3; k++)
+        {
+            uint32_t v{ triangle[k] };
+            uint32_t* list{ &adjacency[firstTriangle[v]] };
+            uint32_t* last{ list + remaining[v] - 1 };
+            *std::find(list, last, static_cast<uint32_t>(best)) = *last;
+            remaining[v]--;
+        }
+
+        // Most recent first; whatever falls past the end is evicted
+        nextCache.assign(triangle, triangle + 3);
+        for (uint32_t v : cache)
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2])
+                nextCache.push_back(v);
+        for (size_t i = forsythCacheSize; i < nextCache.size(); i++)
+        {
+            cachePosition[nextCache[i]] = -1;
+            score[nextCache[i]] = vertexScore(-1, remaining[nextCache[i]]);
+        }
+        if (nextCache.size() > forsythCacheSize)
+            nextCache.resize(forsythCacheSize);
+        cache.swap(nextCache);
+
+        for (size_t i = 0; i < cache.size(); i++)
+        {
+            cachePosition[cache[i]] = static_cast<int>(i);
+            score[cache[i]] = vertexScore(static_cast<int>(i), remaining[cache[i]]);
+        }
+
+        // Only triangles touching the cache changed score, the best next one is among them
+        best = -1;
+        float bestScore{ -1.0f };
+        for (uint32_t v : cache)
+        {
+            for (size_t i = 0; i < remaining[v]; i++)
+            {
+                uint32_t t{ adjacency[firstTriangle[v] + i] };
+                const uint32_t* corners{ &indices[t * 3] };
+                triangleScore[t] = score[corners[0]] + score[corners[1]] + score[corners[2]];
+                if (triangleScore[t] > bestScore)
+                {
+                    bestScore = triangleScore[t];
+                    best = static_cast<int>(t);
+                }
+            }
+        }
+    }
+    indices.swap(output);
+}
+
+void optimizeOverdraw(Mesh& mesh, float threshold)
+{
+    size_t triangleCount{ mesh.indices.size() / 3 };
+    if (triangleCount < 2 || mesh.stride < 3)
+        return;
+
+    auto position = [&mesh](uint32_t index)
+    {
+        const float* p{ &mesh.vertices[index * mesh.stride] };
+        return glm::vec3(p[0], p[1], p[2]);
+    };
+
+    // Clusters start where the cache restarts: a triangle with no vertex in the FIFO
+    std::vector<size_t> clusterStart{};
+    {
+        const unsigned cacheSize{ 16 };
+        std::vector<size_t> missedAt(mesh.vertexCount(), 0);
+        size_t misses{};
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            int triangleMisses{};
+            for (int k = 0; k < 3; k++)
+            {
+                uint32_t index{ mesh.indices[t * 3 + k] };
+                if (missedAt[index] == 0 || misses - missedAt[index] >= cacheSize)
+                {
+                    missedAt[index] = ++misses;
+                    triangleMisses++;
+                }
+            }
+            if (t == 0 || triangleMisses == 3)
+                clusterStart.push_back(t);
+        }
+        clusterStart.push_back(triangleCount);
+    }
+    size_t clusterCount{ clusterStart.size() - 1 };
+    if (clusterCount < 2)
+        return;
+
+    // Area weighted centroid and normal per cluster; facing away from the mesh center means outside
+    glm::vec3 meshCenter{ 0.0f };
+    float meshArea{};
+    std::vector<glm::vec3> clusterCenter(clusterCount, glm::vec3(0.0f)), clusterNormal(clusterCount, glm::vec3(0.0f));
+    std::vector<float> clusterArea(clusterCount, 0.0f);
+    for (size_t c = 0; c < clusterCount; c++)
+    {
+        for (size_t t = clusterStart[c]; t < clusterStart[c + 1]; t++)
+        {
+            glm::vec3 a{ position(mesh.indices[t * 3]) }, b{ position(mesh.indices[t * 3 + 1]) }, d{ position(mesh.indices[t * 3 + 2]) };
+            glm::vec3 normal{ glm::cross(b - a, d - a) };
+            float area{ glm::length(normal) };
+            clusterCenter[c] += (a + b + d) * (area / 3.0f);
+            clusterNormal[c] += normal;
+            clusterArea[c] += area;
+        }
+        meshCenter += clusterCenter[c];
+        meshArea += clusterArea[c];
+    }
+    if (meshArea <= 0.0f)
+        return;
+    meshCenter /= meshArea;
+
+    std::vector<float> sortKey(clusterCount, 0.0f);
+    for (size_t c = 0; c < clusterCount; c++)
+    {
+        if (clusterArea[c] <= 0.0f)
+            continue;
+        glm::vec3 center{ clusterCenter[c] / clusterArea[c] };
+        float normalLength{ glm::length(clusterNormal[c]) };
+        if (normalLength > 0.0f)
+            sortKey[c] = glm::dot(center - meshCenter, clusterNormal[c] / normalLength);
+    }
+
+    std::vector<size_t> order(clusterCount);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&sortKey](size_t a, size_t b) { return sortKey[a] > sortKey[b]; });
+
+    std::vector<uint32_t> sorted{};
+    sorted.reserve(mesh.indices.size());
+    for (size_t c : order)
+        sorted.insert(sorted.end(), mesh.indices.begin() + clusterStart[c] * 3, mesh.indices.begin() + clusterStart[c + 1] * 3);
+
+    float before{ analyzeVertexCache(mesh).acmr };
+    std::swap(mesh.indices, sorted);
+    if (analyzeVertexCache(mesh).acmr > before * threshold)
+        std::swap(mesh.indices, sorted); // overdraw isn't worth that many vertex shader runs
+}
+
+void optimizeVertexFetch(Mesh& mesh)
+{
+    const uint32_t unused{ ~0u };
+    std::vector<uint32_t> remap(mesh.vertexCount(), unused);
+    std::vector<float> vertices{};
+    vertices.reserve(mesh.vertices.size());
+
+    uint32_t next{};
+    for (uint32_t& index : mesh.indices)
+    {
+        if (remap[index] == unused)
+        {
+            remap[index] = next++;
+            const float* vertex{ &mesh.vertices[index * mesh.stride] };
+            vertices.insert(vertices.end(), vertex, vertex + mesh.stride);
+        }
+        index = remap[index];
+    }
+    mesh.vertices.swap(vertices);
+}
+
+void optimizeMesh(Mesh& mesh, const char* name, FILE* log)
+{
+    VertexCacheStats before{ analyzeVertexCache(mesh) };
+    optimizeVertexCache(mesh);
+    optimizeOverdraw(mesh);
+    optimizeVertexFetch(mesh);
+    VertexCacheStats after{ analyzeVertexCache(mesh) };
+
+    if (log)
+        fprintf(log, "%s: %zu triangles, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", name, mesh.indices.size() / 3,
+                before.acmr, after.acmr, before.atvr, after.atvr);
+}
+
+namespace
+{
+    glm::vec3 positionOf(const Mesh& mesh, uint32_t index)
+    {
+        const float* p{ &mesh.vertices[size_t(index) * mesh.stride] };
+        return glm::vec3(p[0], p[1], p[2]);
+    }
+
+    // Triangles by their corner positions, each rotated to start at its smallest corner so
+    // the winding is kept, then sorted: equal lists are the same surface in any order
+    std::vector<std::array<float, 9>> triangleSet(const Mesh& mesh)
+    {
+        std::vector<std::array<float, 9>> triangles(mesh.indices.size() / 3);
+        for (size_t t = 0; t < triangles.size(); t++)
+        {
+            glm::vec3 corners[3]{};
+            for (int k = 0; k < 3; k++)
+                corners[k] = positionOf(mesh, mesh.indices[t * 3 + k]);
+            auto less = [](const glm::vec3& a, const glm::vec3& b) { return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z); };
+            int first{ static_cast<int>(std::min_element(corners, corners + 3, less) - corners) };
+            for (int k = 0; k < 3; k++)
+            {
+                const glm::vec3& corner{ corners[(first + k) % 3] };
+                triangles[t][k * 3 + 0] = corner.x;
+                triangles[t][k * 3 + 1] = corner.y;
+                triangles[t][k * 3 + 2] = corner.z;
+            }
+        }
+        std::sort(triangles.begin(), triangles.end());
+        return triangles;
+    }
+}
+
+bool checkMeshOptimizer(FILE* log)
+{
+    // Bounds for a 16 entry FIFO on a regular grid: 0.5 / 1.0 are the ideal, row order
+    // without optimization lands near 1.0 / 2.0 and the shuffled input near 3.0 / 5.8
+    const int side{ 64 };
+    const float maxAcmr{ 0.8f };
+    const float maxAtvr{ 1.6f };
+
+    Mesh grid{};
+    for (int y = 0; y < side; y++)
+    {
+        for (int x = 0; x < side; x++)
+        {
+            grid.vertices.push_back(static_cast<float>(x));
+            grid.vertices.push_back(static_cast<float>(y));
+            grid.vertices.push_back(0.0f);
+        }
+    }
+    std::vector<std::array<uint32_t, 3>> triangles{};
+    for (uint32_t y = 0; y + 1 < side; y++)
+    {
+        for (uint32_t x = 0; x + 1 < side; x++)
+        {
+            uint32_t corner{ y * side + x };
+            triangles.push_back({ { corner, corner + 1, corner + side } });
+            triangles.push_back({ { corner + 1, corner + side + 1, corner + side } });
+        }
+    }
+    // Fixed LCG shuffle, the same input every run
+    uint32_t state{ 12345 };
+    for (size_t i = triangles.size() - 1; i > 0; i--)
+    {
+        state = state * 1664525u + 1013904223u;
+        std::swap(triangles[i], triangles[(state >> 8) % (i + 1)]);
+    }
+    for (const std::array<uint32_t, 3>& triangle : triangles)
+        grid.indices.insert(grid.indices.end(), triangle.begin(), triangle.end());
+
+    std::vector<std::array<float, 9>> expected{ triangleSet(grid) };
+    optimizeMesh(grid, "grid", log);
+    VertexCacheStats stats{ analyzeVertexCache(grid) };
+
+    bool passed{ true };
+    if (stats.acmr > maxAcmr || stats.atvr > maxAtvr)
+    {
+        fprintf(log, "optimizeMesh: grid ACMR %.3f / ATVR %.3f, expected at most %.3f / %.3f\n",
+                stats.acmr, stats.atvr, maxAcmr, maxAtvr);
+        passed = false;
+    }
+    if (grid.vertexCount() != size_t(side) * side || triangleSet(grid) != expected)
+    {
+        fprintf(log, "optimizeMesh: grid triangles changed\n");
+        passed = false;
+    }
+    return passed;
+}
+
+namespace
+{
+
+    void computeMeshletBounds(const Mesh& mesh, Meshlet& meshlet)
+    {
+        const uint32_t* indices{ mesh.indices.data() + meshlet.firstIndex };
+        glm::vec3 low{ positionOf(mesh, indices[0]) }, high{ low };
+        for (uint32_t i = 1; i < meshlet.indexCount; i++)
+        {
+            low = glm::min(low, positionOf(mesh, indices[i]));
+            high = glm::max(high, positionOf(mesh, indices[i]));
+        }
+        glm::vec3 center{ (low + high) * 0.5f };
+        float radius{};
+        for (uint32_t i = 0; i < meshlet.indexCount; i++)
+            radius = std::max(radius, glm::length(positionOf(mesh, indices[i]) - center));
+
+        // Cone around the mean face normal; when the normals spread over a hemisphere or
+        // more there is no direction all faces turn away from, the cluster is never culled
+        std::vector<glm::vec3> normals{};
+        glm::vec3 axis{ 0.0f };
+        for (uint32_t i = 0; i + 2 < meshlet.indexCount; i += 3)
+        {
+            glm::vec3 a{ positionOf(mesh, indices[i]) };
+            glm::vec3 n{ glm::cross(positionOf(mesh, indices[i + 1]) - a, positionOf(mesh, indices[i + 2]) - a) };
+            float length{ glm::length(n) };
+            if (length > 0.0f)
+            {
+                normals.push_back(n / length);
+                axis += normals.back();
+            }
+        }
+        float cutoff{ 1.0f };
+        if (glm::length(axis) > 0.0f)
+        {
+            axis = glm::normalize(axis);
+            float spread{ 1.0f };
+            for (const glm::vec3& n : normals)
+                spread = std::min(spread, glm::dot(axis, n));
+            if (spread > 0.1f)
+                cutoff = std::sqrt(1.0f - spread * spread);
+        }
+
+        for (int i = 0; i < 3; i++)
+        {
+            meshlet.center[i] = center[i];
+            meshlet.coneAxis[i] = axis[i];
+        }
+        meshlet.radius = radius;
+        meshlet.coneCutoff = cutoff;
+    }
+}
+
+std::vector<Meshlet> buildMeshlets(const Mesh& mesh, unsigned maxVertices, unsigned maxTriangles)
+{
+    std::vector<Meshlet> meshlets{};
+    if (mesh.indices.size() < 3 || mesh.stride < 3 || maxVertices < 3 || !maxTriangles)
+        return meshlets;
+
+    // owner[v] is the meshlet that last counted v, so the count needs no clearing
+    std::vector<uint32_t> owner(mesh.vertexCount(), UINT32_MAX);
+    uint32_t id{};
+    auto newVertices = [&](size_t i)
+    {
+        uint32_t a{ mesh.indices[i] }, b{ mesh.indices[i + 1] }, c{ mesh.indices[i + 2] };
+        return unsigned(owner[a] != id) + unsigned(owner[b] != id && b != a) + unsigned(owner[c] != id && c != a && c != b);
+    };
+
+    Meshlet current{};
+    for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+    {
+        unsigned added{ newVertices(i) };
+        if (current.indexCount && (current.vertexCount + added > maxVertices || current.indexCount / 3 >= maxTriangles))
+        {
+            meshlets.push_back(current);
+            current = Meshlet{};
+            current.firstIndex = static_cast<uint32_t>(i);
+            id++;
+            added = newVertices(i);
+        }
+        for (int k = 0; k < 3; k++)
+            owner[mesh.indices[i + k]] = id;
+        current.vertexCount += added;
+        current.indexCount += 3;
+    }
+    meshlets.push_back(current);
+
+    for (Meshlet& meshlet : meshlets)
+        computeMeshletBounds(mesh, meshlet);
+    return meshlets;
+}
+
+namespace
+{
+    // Sum of squared distances to weighted planes, the symmetric 4x4 matrix stored as its
+    // upper triangle; weight is the total that went in, error() is the weighted mean
+    struct Quadric
+    {
+        double a00{}, a01{}, a02{}, a11{}, a12{}, a22{};
+        double b0{}, b1{}, b2{}, c{};
+        double weight{};
+
+        void addPlane(const glm::dvec3& n, double d, double w)
+        {
+            a00 += w * n.x * n.x; a01 += w * n.x * n.y; a02 += w * n.x * n.z;
+            a11 += w * n.y * n.y; a12 += w * n.y * n.z; a22 += w * n.z * n.z;
+            b0 += w * n.x * d; b1 += w * n.y * d; b2 += w * n.z * d;
+            c += w * d * d;
+            weight += w;
+        }
+
+        Quadric& operator+=(const Quadric& other)
+        {
+            a00 += other.a00; a01 += other.a01; a02 += other.a02;
+            a11 += other.a11; a12 += other.a12; a22 += other.a22;
+            b0 += other.b0; b1 += other.b1; b2 += other.b2;
+            c += other.c;
+            weight += other.weight;
+            return *this;
+        }
+
+        double error(const glm::dvec3& p) const
+        {
+            double sum{ a00 * p.x * p.x + a11 * p.y * p.y + a22 * p.z * p.z +
+                        2.0 * (a01 * p.x * p.y + a02 * p.x * p.z + a12 * p.y * p.z) +
+                        2.0 * (b0 * p.x + b1 * p.y + b2 * p.z) + c };
+            return weight > 0.0 ? std::max(sum, 0.0) / weight : 0.0;
+        }
+    };
+
+    enum class VertexKind : uint8_t
+    {
+        Interior,   // collapses along any edge
+        Border,     // on an open edge, only slides along it
+        Locked      // attribute seam, non-manifold or a border corner, never moves
+    };
+
+    uint64_t edgeKey(uint32_t a, uint32_t b)
+    {
+        return a < b ? (uint64_t(a) << 32 | b) : (uint64_t(b) << 32 | a);
+    }
+
+    // Position groups of a vertex ring and how often each undirected group edge is used
+    std::unordered_map<uint64_t, unsigned> countEdges(const std::vector<uint32_t>& indices, const std::vector<uint32_t>& group)
+    {
+        std::unordered_map<uint64_t, unsigned> edges{};
+        edges.reserve(indices.size());
+        for (size_t i = 0; i + 2 < indices.size(); i += 3)
+            for (int k = 0; k < 3; k++)
+                edges[edgeKey(group[indices[i + k]], group[indices[i + (k + 1) % 3]])]++;
+        return edges;
+    }
+
+    struct Collapse
+    {
+        uint32_t from{};    // vertex that goes away
+        uint32_t to{};      // vertex its corners are moved to
+        double   cost{};    // squared geometric error plus the attribute change
+        double   error{};   // squared geometric error alone
+    };
+}
+
+std::vector<uint32_t> simplifyMesh(const Mesh& mesh, size_t targetIndexCount, float maxError, float* error, float attributeWeight)
+{
+    std::vector<uint32_t> result{ mesh.indices };
+    if (error)
+        *error = 0.0f;
+    size_t vertexCount{ mesh.vertexCount() };
+    if (result.size() <= targetIndexCount || mesh.stride < 3 || !vertexCount)
+        return result;
+
+    // Positions relative to the bounding sphere of MeshFile::pack(), so errors are in radii
+    glm::vec3 low{ positionOf(mesh, 0) }, high{ low };
+    for (uint32_t v = 1; v < vertexCount; v++)
+    {
+        low = glm::min(low, positionOf(mesh, v));
+        high = glm::max(high, positionOf(mesh, v));
+    }
+    glm::vec3 center{ (low + high) * 0.5f };
+    float radius{};
+    for (uint32_t v = 0; v < vertexCount; v++)
+        radius = std::max(radius, glm::length(positionOf(mesh, v) - center));
+    if (radius <= 0.0f)
+        return result;
+    std::vector<glm::dvec3> positions(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; v++)
+        positions[v] = glm::dvec3((positionOf(mesh, v) - center) / radius);
+
+    // Vertices at one position but with different attributes are one group; a group of more
+    // than one vertex lies on a seam, collapsing it would tear the seam open
+    MeshBuilder welder{ 3 };
+    std::vector<uint32_t> group(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; v++)
+        group[v] = welder.addVertex(&mesh.vertices[size_t(v) * mesh.stride]);
+    size_t groupCount{ welder.mesh().vertexCount() };
+    std::vector<unsigned> groupSize(groupCount, 0);
+    for (uint32_t v = 0; v < vertexCount; v++)
+        groupSize[group[v]]++;
+
+    std::vector<VertexKind> kind(groupCount, VertexKind::Interior);
+    std::vector<unsigned> borderEdges(groupCount, 0);
+    std::unordered_map<uint64_t, unsigned> edges{ countEdges(result, group) };
+    for (const std::pair<const uint64_t, unsigned>& edge : edges)
+    {
+        uint32_t a{ uint32_t(edge.first >> 32) }, b{ uint32_t(edge.first) };
+        if (edge.second == 1)
+        {
+            borderEdges[a]++;
+            borderEdges[b]++;
+        }
+        else if (edge.second > 2)
+        {
+            kind[a] = VertexKind::Locked;
+            kind[b] = VertexKind::Locked;
+        }
+    }
+    for (size_t g = 0; g < groupCount; g++)
+    {
+        if (groupSize[g] > 1 || (borderEdges[g] && borderEdges[g] != 2))
+            kind[g] = VertexKind::Locked;
+        else if (borderEdges[g] && kind[g] == VertexKind::Interior)
+            kind[g] = VertexKind::Border;
+    }
+
+    // Area weighted face planes; an open edge also gets a stiff plane through it, upright
+    // on the face, which keeps the outline where it is
+    const double borderWeight{ 10.0 };
+    std::vector<Quadric> quadrics(groupCount);
+    for (size_t i = 0; i + 2 < result.size(); i += 3)
+    {
+        const glm::dvec3& a{ positions[result[i]] };
+        glm::dvec3 normal{ glm::cross(positions[result[i + 1]] - a, positions[result[i + 2]] - a) };
+        double area{ glm::length(normal) * 0.5 };
+        if (area <= 0.0)
+            continue;
+        normal = glm::normalize(normal);
+        for (int k = 0; k < 3; k++)
+            quadrics[group[result[i + k]]].addPlane(normal, -glm::dot(normal, a), area);
+
+        for (int k = 0; k < 3; k++)
+        {
+            uint32_t from{ result[i + k] }, to{ result[i + (k + 1) % 3] };
+            if (edges[edgeKey(group[from], group[to])] != 1)
+                continue;
+            glm::dvec3 edge{ positions[to] - positions[from] };
+            double length{ glm::length(edge) };
+            if (length <= 0.0)
+                continue;
+            glm::dvec3 side{ glm::normalize(glm::cross(edge, normal)) };
+            double d{ -glm::dot(side, positions[from]) };
+            quadrics[group[from]].addPlane(side, d, length * length * borderWeight);
+            quadrics[group[to]].addPlane(side, d, length * length * borderWeight);
+        }
+    }
+
+    // Everything after the position is an attribute; its change along the edge adds to the cost
+    int attributeCount{ mesh.stride - 3 };
+    auto attributeCost = [&](uint32_t from, uint32_t to)
+    {
+        if (attributeCount <= 0)
+            return 0.0;
+        const float* a{ &mesh.vertices[size_t(from) * mesh.stride + 3] };
+        const float* b{ &mesh.vertices[size_t(to) * mesh.stride + 3] };
+        double sum{};
+        for (int i = 0; i < attributeCount; i++)
+            sum += double(a[i] - b[i]) * (a[i] - b[i]);
+        return attributeWeight * sum / attributeCount;
+    };
+
+    // Passes of independent collapses, cheapest first: a collapse touches the ring around
+    // the vertex it removes, nothing else in that ring moves in the same pass
+    double errorLimit{ double(maxError) * maxError };
+    double largest{};
+    size_t triangleCount{ result.size() / 3 };
+    std::vector<uint32_t> remap(vertexCount);
+    std::vector<uint8_t> touched(groupCount);
+    std::vector<size_t> firstTriangle(vertexCount + 1);
+    std::vector<uint32_t> adjacency{};
+    std::vector<Collapse> best(vertexCount);
+    std::vector<Collapse> candidates{};
+    while (triangleCount * 3 > targetIndexCount)
+    {
+        // Triangles around every vertex
+        std::fill(firstTriangle.begin(), firstTriangle.end(), 0);
+        for (uint32_t index : result)
+            firstTriangle[index + 1]++;
+        for (size_t v = 0; v < vertexCount; v++)
+            firstTriangle[v + 1] += firstTriangle[v];
+        adjacency.resize(result.size());
+        {
+            std::vector<size_t> cursor(firstTriangle.begin(), firstTriangle.end() - 1);
+            for (size_t i = 0; i < result.size(); i++)
+                adjacency[cursor[result[i]]++] = static_cast<uint32_t>(i / 3);
+        }
+        edges = countEdges(result, group);
+
+        // Cheapest way out for every vertex that may move
+        for (Collapse& collapse : best)
+            collapse.cost = -1.0;
+        for (size_t i = 0; i + 2 < result.size(); i += 3)
+        {
+            for (int k = 0; k < 3; k++)
+            {
+                for (int step = 1; step < 3; step++)
+                {
+                    uint32_t from{ result[i + k] }, to{ result[i + (k + step) % 3] };
+                    uint32_t fromGroup{ group[from] }, toGroup{ group[to] };
+                    if (kind[fromGroup] == VertexKind::Locked || fromGroup == toGroup)
+                        continue;
+                    if (kind[fromGroup] == VertexKind::Border && edges[edgeKey(fromGroup, toGroup)] != 1)
+                        continue;
+                    Quadric merged{ quadrics[fromGroup] };
+                    merged += quadrics[toGroup];
+                    double geometric{ merged.error(positions[to]) };
+                    double cost{ geometric + attributeCost(from, to) };
+                    if (best[from].cost < 0.0 || cost < best[from].cost)
+                        best[from] = { from, to, cost, geometric };
+                }
+            }
+        }
+        candidates.clear();
+        for (const Collapse& collapse : best)
+            if (collapse.cost >= 0.0 && collapse.error <= errorLimit)
+                candidates.push_back(collapse);
+        if (candidates.empty())
+            break;
+        std::sort(candidates.begin(), candidates.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+        std::iota(remap.begin(), remap.end(), 0u);
+        std::fill(touched.begin(), touched.end(), uint8_t(0));
+        size_t collapsed{};
+        for (const Collapse& collapse : candidates)
+        {
+            if (triangleCount * 3 <= targetIndexCount)
+                break;
+            uint32_t fromGroup{ group[collapse.from] }, toGroup{ group[collapse.to] };
+            if (touched[fromGroup] || touched[toGroup])
+                continue;
+
+            // Reject collapses that turn a remaining triangle over or fold it flat
+            bool flips{};
+            unsigned removed{};
+            for (size_t a = firstTriangle[collapse.from]; a < firstTriangle[collapse.from + 1] && !flips; a++)
+            {
+                const uint32_t* triangle{ &result[size_t(adjacency[a]) * 3] };
+                if (group[triangle[0]] == toGroup || group[triangle[1]] == toGroup || group[triangle[2]] == toGroup)
+                {
+                    removed++;
+                    continue;
+                }
+                glm::dvec3 p[3]{}, moved[3]{};
+                for (int k = 0; k < 3; k++)
+                {
+                    p[k] = positions[triangle[k]];
+                    moved[k] = triangle[k] == collapse.from ? positions[collapse.to] : p[k];
+                }
+                glm::dvec3 before{ glm::cross(p[1] - p[0], p[2] - p[0]) };
+                glm::dvec3 after{ glm::cross(moved[1] - moved[0], moved[2] - moved[0]) };
+                flips = glm::dot(before, after) <= 0.25 * glm::length(before) * glm::length(after);
+            }
+            if (flips)
+                continue;
+
+            for (size_t a = firstTriangle[collapse.from]; a < firstTriangle[collapse.from + 1]; a++)
+                for (int k = 0; k < 3; k++)
+                    touched[group[result[size_t(adjacency[a]) * 3 + k]]] = 1;
+            remap[collapse.from] = collapse.to;
+            quadrics[toGroup] += quadrics[fromGroup];
+            largest = std::max(largest, collapse.error);
+            triangleCount -= removed;
+            collapsed++;
+        }
+        if (!collapsed)
+            break;
+
+        // Move the corners and drop the triangles that lost an edge
+        size_t kept{};
+        for (size_t i = 0; i + 2 < result.size(); i += 3)
+        {
+            uint32_t a{ remap[result[i]] }, b{ remap[result[i + 1]] }, c{ remap[result[i + 2]] };
+            if (group[a] == group[b] || group[b] == group[c] || group[a] == group[c])
+                continue;
+            result[kept++] = a;
+            result[kept++] = b;
+            result[kept++] = c;
+        }
+        result.resize(kept);
+        triangleCount = kept / 3;
+    }
+
+    if (error)
+        *error = static_cast<float>(std::sqrt(largest));
+    return result;
+}
+
+void buildLods(const Mesh& mesh, unsigned maxLods, std::vector<std::vector<uint32_t>>& lods, std::vector<float>& errors)
+{
+    lods.assign(maxLods, {});
+    errors.assign(maxLods, 0.0f);
+
+    // Every level starts from the full mesh, so they are independent and build side by side
+    std::vector<std::thread> workers{};
+    for (unsigned level = 0; level < maxLods; level++)
+    {
+        workers.emplace_back([&mesh, &lods, &errors, level]
+        {
+            size_t target{ mesh.indices.size() / 3 >> (level + 1) };
+            lods[level] = simplifyMesh(mesh, target * 3, 1.0f, &errors[level]);
+            optimizeVertexCache(lods[level], mesh.vertexCount());
+        });
+    }
+    for (std::thread& worker : workers)
+        worker.join();
+
+    // The chain ends at the first level that stopped short, locked seams and borders do that
+    size_t previous{ mesh.indices.size() };
+    float error{};
+    for (unsigned level = 0; level < lods.size(); level++)
+    {
+        if (lods[level].empty() || lods[level].size() > previous * 3 / 4)
+        {
+            lods.resize(level);
+            errors.resize(level);
+            break;
+        }
+        previous = lods[level].size();
+        error = errors[level] = std::max(errors[level], error);
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdio>
+#include <vector>
+
+#include "MeshBuilder.h"
+#include "MeshFile.h"
+
+// Post-transform cache behaviour of an index buffer, simulated as a FIFO of cacheSize
+struct VertexCacheStats
+{
+    float acmr{};   // vertex shader runs per triangle: 0.5 is ideal, 3 is no reuse at all
+    float atvr{};   // vertex shader runs per unique vertex: 1 is ideal
+};
+
+VertexCacheStats analyzeVertexCache(const Mesh& mesh, unsigned cacheSize = 16);
+
+// Forsyth's linear-speed ordering: triangles whose vertices are still in the cache go first,
+// low-valence vertices get a boost so they are finished and leave the cache early.
+void optimizeVertexCache(Mesh& mesh);
+void optimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount);   // an index list over shared vertices, a LOD
+
+// Tipsify-style: cuts the cache-ordered triangles into clusters where the cache would restart
+// and sorts the clusters outside-in, so front surfaces tend to be drawn before what they hide.
+// Kept only if ACMR grows by less than threshold. Positions are the first 3 floats.
+void optimizeOverdraw(Mesh& mesh, float threshold = 1.05f);
+
+// Renumbers vertices in first-use order so vertex fetch walks memory forward; unused
+// vertices are dropped.
+void optimizeVertexFetch(Mesh& mesh);
+
+// All three in order; a non-null log gets one ACMR/ATVR before -> after line
+void optimizeMesh(Mesh& mesh, const char* name = "mesh", FILE* log = nullptr);
+
+// Self-check of optimizeMesh() on a 64x64 vertex grid with its triangles shuffled: ACMR and
+// ATVR have to end below fixed bounds and the same triangles, same winding, have to come out.
+// Failures go to log; false if any.
+bool checkMeshOptimizer(FILE* log);
+
+// Cuts the index order as it is into meshlets of at most maxVertices unique vertices and
+// maxTriangles triangles, so run it after optimizeMesh(): the cache order already keeps
+// neighbouring triangles together. Bounds and normal cones come from the face normals of
+// the positions (first 3 floats), counter-clockwise triangles facing out.
+std::vector<Meshlet> buildMeshlets(const Mesh& mesh, unsigned maxVertices = 64, unsigned maxTriangles = 124);
+
+// Quadric error edge collapse (Garland-Heckbert) down to about targetIndexCount indices. A
+// collapse moves a vertex onto a neighbour, so the result indexes the mesh's own vertices,
+// one LOD for MeshFile::pack(). Stops early where the next collapse would move the surface
+// by more than maxError; error gets the largest taken, both relative to the bounding radius.
+// Vertices on an attribute seam (one position, several vertices) stay, open borders only
+// slide along themselves, and the change of the floats after the position costs
+// attributeWeight times their mean squared difference.
+std::vector<uint32_t> simplifyMesh(const Mesh& mesh, size_t targetIndexCount, float maxError = 1.0f,
+                                   float* error = nullptr, float attributeWeight = 0.05f);
+
+// Up to maxLods levels of half the triangles of the one before, each simplified from the full
+// mesh on a thread of its own and cache optimized. The chain ends where simplification stalls;
+// errors never decrease along it.
+void buildLods(const Mesh& mesh, unsigned maxLods, std::vector<std::vector<uint32_t>>& lods, std::vector<float>& errors);
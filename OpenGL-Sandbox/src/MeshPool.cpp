@@ -0,0 +1,147 @@
+#include "MeshPool.h"
+
+#include <cstdio>
+#include <cstring>
+
+bool MeshPool::init(GLsizeiptr vertexBytes, GLsizeiptr indexBytes)
+{
+    shutdown();
+
+    // Filled once per mesh, never per frame, so plain sub data uploads are enough
+    vertexCapacity = vertexBytes;
+    indexCapacity = indexBytes / sizeof(GLuint);
+    glCreateBuffers(1, &vertexBuffer);
+    glNamedBufferStorage(vertexBuffer, vertexCapacity, nullptr, GL_DYNAMIC_STORAGE_BIT);
+    glCreateBuffers(1, &indexBuffer);
+    glNamedBufferStorage(indexBuffer, indexCapacity * sizeof(GLuint), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+    glCreateVertexArrays(1, &vao);
+    glVertexArrayElementBuffer(vao, indexBuffer);
+    return true;
+}
+
+void MeshPool::shutdown()
+{
+    glDeleteVertexArrays(1, &vao);
+    glDeleteBuffers(1, &vertexBuffer);
+    glDeleteBuffers(1, &indexBuffer);
+    vao = vertexBuffer = indexBuffer = 0;
+    vertexCapacity = indexCapacity = vertexHead = indexHead = 0;
+    stride = 0;
+    attributes.clear();
+}
+
+bool MeshPool::matchesLayout(const MeshFile& mesh) const
+{
+    const MeshFileHeader& header{ mesh.header() };
+    if (header.vertexStride != stride || header.attributeCount != attributes.size())
+        return false;
+    return memcmp(mesh.attributes(), attributes.data(), attributes.size() * sizeof(MeshAttribute)) == 0;
+}
+
+bool MeshPool::add(const MeshFile& mesh, MeshRange& range)
+{
+    const MeshFileHeader& header{ mesh.header() };
+    if (stride && !matchesLayout(mesh))
+    {
+        fprintf(stderr, "Mesh pool: vertex layout differs from the pool's\n");
+        return false;
+    }
+
+    // baseVertex counts whole vertices, so the stream starts on a multiple of the stride
+    GLsizeiptr vertexStart{ (vertexHead + header.vertexStride - 1) / header.vertexStride * header.vertexStride };
+    if (vertexStart + GLsizeiptr(mesh.vertexSize()) > vertexCapacity || indexHead + GLsizeiptr(header.indexCount) > indexCapacity)
+    {
+        fprintf(stderr, "Mesh pool: %u vertices and %u indices don't fit\n", header.vertexCount, header.indexCount);
+        return false;
+    }
+
+    if (!stride)
+    {
+        stride = header.vertexStride;
+        attributes.assign(mesh.attributes(), mesh.attributes() + header.attributeCount);
+        glVertexArrayVertexBuffer(vao, 0, vertexBuffer, 0, stride);
+        for (const MeshAttribute& attribute : attributes)
+        {
+            glVertexArrayAttribFormat(vao, attribute.location, attribute.components, attribute.type,
+                                      attribute.normalized ? GL_TRUE : GL_FALSE, attribute.offset);
+            glVertexArrayAttribBinding(vao, attribute.location, 0);
+            glEnableVertexArrayAttrib(vao, attribute.location);
+        }
+    }
+
+    glNamedBufferSubData(vertexBuffer, vertexStart, mesh.vertexSize(), mesh.vertexData());
+    if (header.indexType == GL_UNSIGNED_INT)
+    {
+        glNamedBufferSubData(indexBuffer, indexHead * sizeof(GLuint), mesh.indexSize(), mesh.indexData());
+    }
+    else
+    {
+        std::vector<GLuint> wide(header.indexCount);
+        const uint16_t* narrow{ reinterpret_cast<const uint16_t*>(mesh.indexData()) };
+        for (size_t i = 0; i < wide.size(); i++)
+            wide[i] = narrow[i];
+        glNamedBufferSubData(indexBuffer, indexHead * sizeof(GLuint), wide.size() * sizeof(GLuint), wide.data());
+    }
+
+    describeMesh(mesh, static_cast<GLint>(vertexStart / stride), static_cast<GLuint>(indexHead), range);
+    vertexHead = vertexStart + mesh.vertexSize();
+    indexHead += header.indexCount;
+    return true;
+}
+
+void describeMesh(const MeshFile& mesh, GLint baseVertex, GLuint firstIndex, MeshRange& range)
+{
+    const MeshFileHeader& header{ mesh.header() };
+    range.baseVertex = baseVertex;
+    range.lods.assign(mesh.lods(), mesh.lods() + header.lodCount);
+    for (MeshLod& lod : range.lods)
+        lod.firstIndex += firstIndex;
+    range.meshlets.assign(mesh.meshlets(), mesh.meshlets() + header.meshletCount);
+    for (Meshlet& meshlet : range.meshlets)
+        meshlet.firstIndex += firstIndex;
+
+    const glm::vec3 offset{ header.positionOffset[0], header.positionOffset[1], header.positionOffset[2] };
+    const glm::vec3 scale{ header.positionScale[0], header.positionScale[1], header.positionScale[2] };
+    range.decode = glm::mat4{ 1.0f };
+    range.decode[0][0] = scale.x;
+    range.decode[1][1] = scale.y;
+    range.decode[2][2] = scale.z;
+    range.decode[3] = glm::vec4(offset, 1.0f);
+
+    range.sphere = glm::vec4(header.center[0], header.center[1], header.center[2], header.radius);
+}
+
+glm::vec4 cameraOf(const glm::mat4& viewProjection)
+{
+    // The eye is the point the projection sends to infinity; an orthographic one has none
+    // and this is the direction back towards it instead
+    glm::vec4 camera{ glm::inverse(viewProjection) * glm::vec4(0.0f, 0.0f, -1.0f, 0.0f) };
+    if (camera.w != 0.0f)
+        camera = glm::vec4(glm::vec3(camera) / camera.w, 1.0f);
+    return camera;
+}
+
+LodSelector::LodSelector(const glm::mat4& viewProjection, float viewportHeight, float pixelError)
+    : camera{ cameraOf(viewProjection) }
+{
+    // Clip space y per world unit, whatever the orientation: the length of the y row
+    glm::vec3 row{ viewProjection[0][1], viewProjection[1][1], viewProjection[2][1] };
+    if (pixelError > 0.0f)
+        scale = glm::length(row) * viewportHeight * 0.5f / pixelError;
+}
+
+size_t LodSelector::select(const MeshRange& mesh, const glm::vec4& sphere) const
+{
+    if (scale <= 0.0f || mesh.lods.size() < 2)
+        return 0;
+    float distance{ camera.w == 0.0f ? 1.0f : glm::length(glm::vec3(sphere) - glm::vec3(camera)) - sphere.w };
+    if (distance <= 0.0f)
+        return 0; // inside the bounds, everything is close
+
+    float budget{ distance / (sphere.w * scale) }; // largest relative error that stays under the pixel limit
+    size_t lod{};
+    while (lod + 1 < mesh.lods.size() && mesh.lods[lod + 1].error <= budget)
+        lod++;
+    return lod;
+}
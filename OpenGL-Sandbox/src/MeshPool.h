@@ -0,0 +1,74 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include <vector>
+
+#include "MeshFile.h"
+
+// Where a mesh landed in a MeshPool: what a DrawElementsIndirectCommand needs to draw it
+struct MeshRange
+{
+    GLint                   baseVertex{};
+    std::vector<MeshLod>    lods{};         // firstIndex already points into the pool's index buffer
+    std::vector<Meshlet>    meshlets{};     // same
+    glm::mat4               decode{ 1.0f }; // quantized positions to mesh space, see below
+    glm::vec4               sphere{};       // mesh space bounds, xyz center, w radius
+};
+
+// World position of the camera of a view projection, or with w 0 the direction back towards
+// an orthographic one
+glm::vec4 cameraOf(const glm::mat4& viewProjection);
+
+// Screen space LOD selection: the coarsest LOD whose error, at the distance of an instance's
+// world bounding sphere, covers at most pixelError pixels. MeshLod::error is relative to the
+// mesh radius, so it scales with the sphere. GPU culling repeats select() per instance.
+struct LodSelector
+{
+    glm::vec4 camera{ 0.0f };               // cameraOf() the view projection
+    float     scale{};                      // pixels per world unit at distance 1, over pixelError; 0 keeps LOD 0
+
+    LodSelector() = default;
+    LodSelector(const glm::mat4& viewProjection, float viewportHeight, float pixelError = 1.0f);
+
+    size_t select(const MeshRange& mesh, const glm::vec4& sphere) const;
+};
+
+// Shared vertex and index megabuffer, so draws of different meshes differ only in their
+// ranges and a whole pass fits one glMultiDrawElementsIndirect. Every mesh of a pool has
+// the vertex layout of the first one added; indices are widened to 32 bit on the way in.
+//
+// Positions are not decoded per draw: the bounds mapping of VertexEncoding::Quantized is
+// MeshRange::decode, which callers fold into the instance transforms of the mesh.
+class MeshPool
+{
+public:
+    static const GLenum indexType{ GL_UNSIGNED_INT };
+
+    bool init(GLsizeiptr vertexBytes, GLsizeiptr indexBytes);
+    void shutdown();
+
+    // Copies the streams of an open mesh file; false when it does not fit or its layout differs
+    bool add(const MeshFile& mesh, MeshRange& range);
+
+    GLuint vertexArray() const { return vao; }
+
+private:
+    bool matchesLayout(const MeshFile& mesh) const;
+
+    GLuint      vao{};
+    GLuint      vertexBuffer{};
+    GLuint      indexBuffer{};
+    GLsizeiptr  vertexCapacity{};
+    GLsizeiptr  indexCapacity{};
+    GLsizeiptr  vertexHead{};               // bytes
+    GLsizeiptr  indexHead{};                // indices
+    uint32_t    stride{};                   // 0 until the first mesh sets the layout
+    std::vector<MeshAttribute> attributes{};
+};
+
+// The range of a mesh whose streams start at baseVertex and firstIndex, what add() fills in
+// after the copy; backends that read the mesh file directly pass 0, 0
+void describeMesh(const MeshFile& mesh, GLint baseVertex, GLuint firstIndex, MeshRange& range);
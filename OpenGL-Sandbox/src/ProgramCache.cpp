@@ -0,0 +1,147 @@
+#include "ProgramCache.h"
+#include "Hash.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+    const uint32_t cacheMagic{ 0x4E494250 }; // "PBIN"
+    const uint32_t cacheVersion{ 1 };
+
+    struct CacheHeader
+    {
+        uint32_t magic{};
+        uint32_t version{};
+        uint64_t key{};
+        uint32_t format{};  // GLenum binaryFormat
+        uint32_t length{};
+    };
+
+    void createDirectory(const std::string& path)
+    {
+#ifdef _WIN32
+        _mkdir(path.c_str());
+#else
+        mkdir(path.c_str(), 0755);
+#endif
+    }
+
+    std::string glString(GLenum name)
+    {
+        const GLubyte* string{ glGetString(name) };
+        return string ? reinterpret_cast<const char*>(string) : "";
+    }
+}
+
+bool ProgramCache::init(const std::string& cacheDirectory)
+{
+    directory = cacheDirectory;
+
+    GLint formats{};
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    supported = formats > 0;
+    if (!supported)
+    {
+        printf("Program binary cache disabled: driver exposes no binary formats\n");
+        return false;
+    }
+
+    // Binaries are only valid for the exact driver build that produced them
+    driverHash = hashString(glString(GL_VENDOR));
+    driverHash = hashString(glString(GL_RENDERER), driverHash);
+    driverHash = hashString(glString(GL_VERSION), driverHash);
+
+    createDirectory(directory);
+    return true;
+}
+
+uint64_t ProgramCache::makeKey(unsigned stageMask) const
+{
+    return hashBytes(&stageMask, sizeof(stageMask), driverHash);
+}
+
+std::string ProgramCache::pathFor(uint64_t key) const
+{
+    std::ostringstream path{};
+    path << directory << "/program-" << std::hex << std::setw(16) << std::setfill('0') << key << ".bin";
+    return path.str();
+}
+
+GLuint ProgramCache::load(uint64_t key) const
+{
+    if (!supported)
+        return 0;
+
+    std::string path{ pathFor(key) };
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return 0;
+
+    CacheHeader header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || header.magic != cacheMagic || header.version != cacheVersion || header.key != key)
+        return 0;
+
+    std::vector<char> binary(header.length);
+    file.read(binary.data(), binary.size());
+    if (!file)
+        return 0;
+    file.close();
+
+    GLuint program{ glCreateProgram() };
+    glProgramBinary(program, header.format, binary.data(), header.length);
+
+    GLint linked{};
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    if (!linked)
+    {
+        // Driver update or a format it no longer accepts: drop the entry and recompile
+        glDeleteProgram(program);
+        std::remove(path.c_str());
+        return 0;
+    }
+    return program;
+}
+
+void ProgramCache::store(uint64_t key, GLuint program) const
+{
+    if (!supported)
+        return;
+
+    GLint linked{}, length{};
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (!linked || length <= 0)
+        return;
+
+    std::vector<char> binary(length);
+    GLenum format{};
+    glGetProgramBinary(program, length, &length, &format, binary.data());
+
+    CacheHeader header{ cacheMagic, cacheVersion, key, format, static_cast<uint32_t>(length) };
+
+    // Write next to the final name and rename, so a crash never leaves a torn binary behind
+    std::string path{ pathFor(key) };
+    std::string tempPath{ path + ".tmp" };
+    {
+        std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+        if (!file)
+            return;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), length);
+        if (!file)
+            return;
+    }
+    std::remove(path.c_str());
+    std::rename(tempPath.c_str(), path.c_str());
+}
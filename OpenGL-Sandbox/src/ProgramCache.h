@@ -0,0 +1,30 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <string>
+
+// On-disk cache of linked program binaries (glGetProgramBinary / glProgramBinary).
+// Keys are built with makeKey() from the driver identity and the enabled stage mask,
+// then the caller mixes in the source of every stage with hashBlock().
+// A binary the driver rejects is deleted and the caller compiles from source.
+class ProgramCache
+{
+public:
+    bool init(const std::string& cacheDirectory = "cache"); // needs a current context
+
+    bool enabled() const { return supported; }
+
+    uint64_t makeKey(unsigned stageMask) const;
+
+    GLuint load(uint64_t key) const;                // 0 on miss or rejected binary
+    void store(uint64_t key, GLuint program) const; // link with GL_PROGRAM_BINARY_RETRIEVABLE_HINT first
+
+private:
+    std::string pathFor(uint64_t key) const;
+
+    std::string directory{};
+    uint64_t    driverHash{};
+    bool        supported{};
+};
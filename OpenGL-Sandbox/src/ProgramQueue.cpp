@@ -0,0 +1,464 @@
+#include "ProgramQueue.h"
+#include "Hash.h"
+#include "ProgramCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_set>
+
+namespace
+{
+    // Magenta, so a program that never becomes ready is obvious on screen
+    const char* fallbackVertex =
+        "#version 450 core\n"
+        "layout (location = 0) in vec4 position;\n"
+        "void main(void) { gl_Position = position; }\n";
+
+    const char* fallbackFragment =
+        "#version 450 core\n"
+        "out vec4 color;\n"
+        "void main(void) { color = vec4(1.0, 0.0, 1.0, 1.0); }\n";
+
+    GLuint compileFallback()
+    {
+        GLuint program{ glCreateProgram() };
+        const GLenum types[] = { GL_VERTEX_SHADER, GL_FRAGMENT_SHADER };
+        const char* sources[] = { fallbackVertex, fallbackFragment };
+        for (int i = 0; i < 2; i++)
+        {
+            GLuint shaderObj{ glCreateShader(types[i]) };
+            glShaderSource(shaderObj, 1, &sources[i], NULL);
+            glCompileShader(shaderObj);
+            glAttachShader(program, shaderObj);
+            glDeleteShader(shaderObj);
+        }
+        glLinkProgram(program);
+        return program;
+    }
+
+    // glShaderBinary() only sees bytes: one module, whole words, the right magic number
+    bool checkSpirv(const ShaderSource& source, const std::string& path)
+    {
+        const uint32_t magic{ 0x07230203 };
+        uint32_t first{};
+        if (source.count() != 1 || source.lengths[0] < static_cast<int>(sizeof(first)))
+        {
+            fprintf(stderr, "%s: SPIR-V module is empty\n", path.c_str());
+            return false;
+        }
+        if (source.lengths[0] % sizeof(first) != 0)
+        {
+            fprintf(stderr, "%s: SPIR-V size %d is not a multiple of 4\n", path.c_str(), source.lengths[0]);
+            return false;
+        }
+        memcpy(&first, source.strings[0], sizeof(first));
+        if (first != magic)
+        {
+            fprintf(stderr, "%s: not a SPIR-V module (magic 0x%08x)\n", path.c_str(), first);
+            return false;
+        }
+        return true;
+    }
+
+    // The program's constants this module declares (OpDecorate SpecId). glSpecializeShader
+    // fails on ids the module lacks, and the others must not split its stage object.
+    std::vector<SpecializationConstant> moduleConstants(const ShaderSource& source, const std::vector<SpecializationConstant>& constants)
+    {
+        const uint32_t opDecorate{ 71 }, decorationSpecId{ 1 };
+        std::vector<SpecializationConstant> used{};
+        std::vector<uint32_t> words(source.lengths[0] / sizeof(uint32_t));
+        memcpy(words.data(), source.strings[0], words.size() * sizeof(uint32_t));
+        for (size_t at = 5; at < words.size();)     // past the header
+        {
+            uint32_t wordCount{ words[at] >> 16 };
+            if (wordCount == 0 || at + wordCount > words.size())
+                break;
+            if ((words[at] & 0xFFFF) == opDecorate && wordCount >= 4 && words[at + 2] == decorationSpecId)
+            {
+                for (const SpecializationConstant& constant : constants)
+                    if (constant.id == words[at + 3])
+                        used.push_back(constant);
+            }
+            at += wordCount;
+        }
+        return used;
+    }
+}
+
+void ProgramQueue::init(const ProgramCache* programCache)
+{
+    cache = programCache;
+
+    if (GLEW_KHR_parallel_shader_compile)
+    {
+        glMaxShaderCompilerThreadsKHR(0xFFFFFFFF); // let the driver pick
+        parallel = true;
+    }
+    else if (GLEW_ARB_parallel_shader_compile)
+    {
+        glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+        parallel = true;
+    }
+    printf("Parallel shader compile: %s\n", parallel ? "yes" : "no");
+
+    spirv = GLEW_VERSION_4_6 || GLEW_ARB_gl_spirv;
+
+    fallback = compileFallback();
+}
+
+void ProgramQueue::shutdown()
+{
+    for (Entry& entry : entries)
+    {
+        glDeleteProgram(entry.program);
+        glDeleteProgram(entry.building);
+    }
+    entries.clear();
+    programHandles.clear();
+    pendingCount = 0;
+
+    for (auto& stage : stageObjects)
+        glDeleteShader(stage.second);
+    stageObjects.clear();
+
+    glDeleteProgram(fallback);
+    fallback = 0;
+}
+
+bool ProgramQueue::prepare(const ProgramDesc& desc, ShaderSource (&sources)[shadersCount],
+                           unsigned& stageMask, uint64_t& programHash, std::vector<std::string>& files)
+{
+    stageMask = 0;
+    programHash = hashSeed;
+    files.clear();
+
+    bool complete{ true };
+    for (int i = 0; i < shadersCount; i++)
+    {
+        if (!isStageEnabled(desc, i))
+            continue;
+
+        // Baked stages come straight out of the archive, no files and no preprocessing. Defines
+        // that are specialization constants were never baked in, only SPIR-V can take them.
+        const Shader& stage{ desc.pipeline[i] };
+        std::vector<std::string> bakedDefines{};
+        for (const std::string& define : desc.defines)
+        {
+            SpecializationConstant constant{};
+            if (!specializationOf(define, constant))
+                bakedDefines.push_back(define);
+        }
+        bool specialized{ bakedDefines.size() != desc.defines.size() };
+        const ShaderArchiveEntry* baked{ archive ? archive->find(ShaderArchive::stageKey(stage.path, bakedDefines)) : nullptr };
+        bool unpacked{ baked && archive->fill(*baked, stage.path, spirv, sources[i]) && (sources[i].spirv || !specialized) };
+        if (!unpacked && !preprocessor.process(stage.path, sources[i], desc.defines))
+        {
+            // Still watch the root file, creating it fixes the program
+            files.push_back(normalizePath(stage.path));
+            complete = false;
+            continue;
+        }
+        files.insert(files.end(), sources[i].files.begin(), sources[i].files.end());
+        stageMask |= 1u << i;
+        if (sources[i].spirv)
+        {
+            // Same module, other constants: another stage object and another program
+            if (!spirv)
+            {
+                fprintf(stderr, "%s: SPIR-V needs GL 4.6 or ARB_gl_spirv\n", stage.path.c_str());
+                complete = false;
+                continue;
+            }
+            if (!checkSpirv(sources[i], stage.path))
+            {
+                complete = false;
+                continue;
+            }
+            for (const SpecializationConstant& constant : moduleConstants(sources[i], desc.constants))
+                sources[i].hash = hashBytes(&constant, sizeof(constant), sources[i].hash);
+        }
+        programHash = hashBytes(&stage.type, sizeof(stage.type), programHash);
+        programHash = hashBytes(&sources[i].hash, sizeof(sources[i].hash), programHash);
+    }
+    return complete;
+}
+
+void ProgramQueue::startBuild(Entry& entry, ShaderSource (&sources)[shadersCount], unsigned stageMask, uint64_t programHash)
+{
+    const Shader* pipeline{ entry.desc.pipeline };
+    entry.buildingHash = programHash;
+    for (uint64_t& stage : entry.buildingStages)
+        stage = 0;
+
+    bool useCache{ cache && cache->enabled() };
+    if (useCache)
+    {
+        // Key: driver identity + enabled stages + every stage source
+        entry.buildingKey = hashBytes(&programHash, sizeof(programHash), cache->makeKey(stageMask));
+
+        GLuint cached{ cache->load(entry.buildingKey) };
+        if (cached)
+        {
+            programReady(entry, cached);
+            return;
+        }
+    }
+
+    entry.building = glCreateProgram();
+    if (useCache)
+        glProgramParameteri(entry.building, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+
+    // None of these wait for the compiler; the first status query does.
+    // Stage objects are shared between programs, a variant that only changes
+    // the fragment shader reuses the compiled vertex shader.
+    for (int i = 0; i < shadersCount; i++)
+    {
+        entry.stageShaders[i] = 0;
+        if (stageMask & (1u << i))
+        {
+            uint64_t stageHash{ hashBytes(&pipeline[i].type, sizeof(pipeline[i].type), sources[i].hash) };
+            GLuint& shaderObj{ stageObjects[stageHash] };
+            if (!shaderObj && sources[i].spirv)
+            {
+                // The front end ran offline; the driver only specializes and lowers
+                std::vector<GLuint> ids{}, values{};
+                for (const SpecializationConstant& constant : moduleConstants(sources[i], entry.desc.constants))
+                {
+                    ids.push_back(constant.id);
+                    values.push_back(constant.value);
+                }
+                shaderObj = glCreateShader(pipeline[i].type);
+                glShaderBinary(1, &shaderObj, GL_SHADER_BINARY_FORMAT_SPIR_V, sources[i].strings[0], sources[i].lengths[0]);
+                if (glSpecializeShader)
+                    glSpecializeShader(shaderObj, "main", static_cast<GLuint>(ids.size()), ids.data(), values.data());
+                else
+                    glSpecializeShaderARB(shaderObj, "main", static_cast<GLuint>(ids.size()), ids.data(), values.data());
+            }
+            else if (!shaderObj)
+            {
+                shaderObj = glCreateShader(pipeline[i].type);
+                glShaderSource(shaderObj, sources[i].count(), sources[i].strings.data(), sources[i].lengths.data());
+                glCompileShader(shaderObj);
+            }
+            glAttachShader(entry.building, shaderObj);
+            entry.buildingStages[i] = stageHash;
+            entry.stageShaders[i] = shaderObj;
+            entry.stageFiles[i] = sources[i].files;
+        }
+    }
+    glLinkProgram(entry.building);
+    pendingCount++;
+}
+
+ProgramQueue::Handle ProgramQueue::submit(const ProgramDesc& desc)
+{
+    Entry entry{};
+    entry.desc = desc;
+    for (int i = 0; i < shadersCount; i++)
+        if (isStageEnabled(desc, i))
+            entry.name += (entry.name.empty() ? "" : " + ") + desc.pipeline[i].path;
+
+    ShaderSource sources[shadersCount]{};
+    unsigned stageMask{};
+    uint64_t programHash{};
+    if (!prepare(desc, sources, stageMask, programHash, entry.files))
+    {
+        // Keeps drawing with the fallback, like a failed link
+        entries.push_back(entry);
+        return static_cast<Handle>(entries.size() - 1);
+    }
+
+    // Same stages with the same expanded sources: it's the same program
+    auto known = programHandles.find(programHash);
+    if (known != programHandles.end())
+        return known->second;
+
+    Handle handle{ static_cast<Handle>(entries.size()) };
+    programHandles[programHash] = handle;
+    entries.push_back(entry);
+    startBuild(entries.back(), sources, stageMask, programHash);
+    return handle;
+}
+
+int ProgramQueue::reload(const std::vector<std::string>& changedFiles)
+{
+    if (changedFiles.empty())
+        return 0;
+
+    // Files on disk are newer than the bake from now on
+    archive = nullptr;
+
+    std::vector<std::string> changed{};
+    for (const std::string& file : changedFiles)
+    {
+        changed.push_back(normalizePath(file));
+        preprocessor.invalidate(file);
+    }
+
+    int reloaded{};
+    for (size_t handle = 0; handle < entries.size(); handle++)
+    {
+        Entry& entry{ entries[handle] };
+
+        bool affected{};
+        for (const std::string& file : entry.files)
+            for (const std::string& path : changed)
+                affected = affected || file == path;
+        if (!affected)
+            continue;
+
+        // A newer edit supersedes a rebuild still in flight
+        if (entry.building)
+        {
+            glDeleteProgram(entry.building);
+            entry.building = 0;
+            pendingCount--;
+            dropBuild(entry);
+        }
+
+        ShaderSource sources[shadersCount]{};
+        unsigned stageMask{};
+        uint64_t programHash{};
+        if (!prepare(entry.desc, sources, stageMask, programHash, entry.files))
+        {
+            fprintf(stderr, "Reload of %s failed, keeping the last good program\n", entry.name.c_str());
+            continue;
+        }
+
+        programHandles[programHash] = static_cast<Handle>(handle);
+        startBuild(entry, sources, stageMask, programHash);
+        reloaded++;
+    }
+    return reloaded;
+}
+
+void ProgramQueue::complete(Entry& entry)
+{
+    pendingCount--;
+
+    // Logs go out even on success, warnings are worth seeing while iterating
+    bool compiled{ true };
+    for (int i = 0; i < shadersCount; i++)
+        if (entry.stageShaders[i])
+            compiled = reportCompileLog(entry.stageShaders[i], entry.stageFiles[i]) && compiled;
+    bool linked{ reportLinkLog(entry.building, entry.name) };
+
+    if (!compiled || !linked)
+    {
+        if (entry.program)
+            fprintf(stderr, "Rebuild of %s failed, keeping the last good program\n", entry.name.c_str());
+        else
+            fprintf(stderr, "Program %s failed, drawing with the fallback\n", entry.name.c_str());
+        glDeleteProgram(entry.building);
+        entry.building = 0;
+        dropBuild(entry);
+        return;
+    }
+
+    if (cache && cache->enabled())
+        cache->store(entry.buildingKey, entry.building);
+
+    programReady(entry, entry.building);
+    entry.building = 0;
+}
+
+void ProgramQueue::programReady(Entry& entry, GLuint linked)
+{
+    // Swapped between frames: poll() runs before any draw of the frame
+    glDeleteProgram(entry.program);
+    entry.program = linked;
+
+    // What the replaced program used goes, unless the new one or another program shares it
+    Handle handle{ static_cast<Handle>(&entry - entries.data()) };
+    auto superseded = programHandles.find(entry.programHash);
+    if (entry.programHash != entry.buildingHash && superseded != programHandles.end() && superseded->second == handle)
+        programHandles.erase(superseded);
+    entry.programHash = entry.buildingHash;
+    for (int i = 0; i < shadersCount; i++)
+    {
+        entry.programStages[i] = entry.buildingStages[i];
+        entry.buildingStages[i] = 0;
+    }
+    releaseStages();
+
+    entry.reflection.reflect(linked);
+}
+
+// A build that failed or was superseded: its hash no longer names this entry's program
+void ProgramQueue::dropBuild(Entry& entry)
+{
+    Handle handle{ static_cast<Handle>(&entry - entries.data()) };
+    auto dropped = programHandles.find(entry.buildingHash);
+    if (entry.buildingHash != entry.programHash && dropped != programHandles.end() && dropped->second == handle)
+        programHandles.erase(dropped);
+    for (uint64_t& stage : entry.buildingStages)
+        stage = 0;
+    releaseStages();
+}
+
+// Stage objects are shared between programs, so they go once no program or build uses them.
+// Programs still hold the shaders they were linked with, deleting only drops the name.
+void ProgramQueue::releaseStages()
+{
+    std::unordered_set<uint64_t> used{};
+    for (const Entry& entry : entries)
+    {
+        for (int i = 0; i < shadersCount; i++)
+        {
+            used.insert(entry.programStages[i]);
+            used.insert(entry.buildingStages[i]);
+        }
+    }
+    for (auto stage = stageObjects.begin(); stage != stageObjects.end();)
+    {
+        if (used.count(stage->first))
+        {
+            ++stage;
+            continue;
+        }
+        glDeleteShader(stage->second);
+        stage = stageObjects.erase(stage);
+    }
+}
+
+void ProgramQueue::poll(int blockingBudget)
+{
+    if (!pendingCount)
+    {
+#ifdef _WIN32
+        // Mapped files can't be rewritten on Windows, release them so editors can save
+        preprocessor.clear();
+#endif
+        return;
+    }
+
+    for (Entry& entry : entries)
+    {
+        if (!entry.building)
+            continue;
+
+        if (parallel)
+        {
+            GLint done{};
+            glGetProgramiv(entry.building, GL_COMPLETION_STATUS_KHR, &done);
+            if (done)
+                complete(entry);
+        }
+        else if (blockingBudget-- > 0)
+        {
+            complete(entry);
+        }
+    }
+}
+
+GLuint ProgramQueue::program(Handle handle) const
+{
+    const Entry& entry{ entries[handle] };
+    return entry.program ? entry.program : fallback;
+}
+
+bool ProgramQueue::ready(Handle handle) const
+{
+    return entries[handle].program != 0;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ProgramReflection.h"
+#include "Shader.h"
+#include "ShaderArchive.h"
+#include "ShaderPreprocessor.h"
+
+class ProgramCache;
+
+// Compiles and links programs off the render thread where the driver allows it.
+// Everything is submitted up front; with KHR/ARB_parallel_shader_compile the driver
+// works on its own threads and poll() only checks GL_COMPLETION_STATUS_KHR. Without
+// the extension the first status query waits for the compiler, so poll() stalls the
+// frame on at most blockingBudget programs. Until a program is ready, program() hands
+// out a built-in fallback, so draws keep working.
+// reload() rebuilds the programs that use changed files the same way, and poll()
+// swaps a rebuilt program in only if it linked, so a typo never breaks the frame.
+class ProgramQueue
+{
+public:
+    using Handle = int;
+
+    void init(const ProgramCache* programCache = nullptr);
+    void shutdown();
+
+    // Stages found in the archive skip the preprocessor, as SPIR-V when the driver takes it.
+    // The first reload() stops using it, edited files on disk win over the bake.
+    void useArchive(const ShaderArchive* shaderArchive) { archive = shaderArchive; }
+
+    // Identical requests (same stages, same expanded sources) return the same handle
+    Handle submit(const ProgramDesc& desc);
+
+    // Rebuilds every program that includes one of these files, returns how many
+    int reload(const std::vector<std::string>& changedFiles);
+
+    // Call once per frame, between frames. Without the extension, checking a program
+    // blocks until it is linked, so at most blockingBudget programs finish per call.
+    void poll(int blockingBudget = 1);
+
+    GLuint program(Handle handle) const;    // linked program, or the fallback
+    bool ready(Handle handle) const;
+    // Of the linked program, empty while the fallback stands in
+    const ProgramReflection& reflection(Handle handle) const { return entries[handle].reflection; }
+
+private:
+    struct Entry
+    {
+        ProgramDesc              desc{};
+        std::string              name{};    // stage files, for logs
+        std::vector<std::string> files{};   // every file the stages pulled in
+        GLuint   program{};                 // last good program, 0 until the first link succeeds
+        GLuint   building{};                // link in flight, first build or reload
+        uint64_t buildingKey{};             // cache key of the program being built
+        uint64_t programHash{};             // programHandles key of program
+        uint64_t buildingHash{};            // and of the build
+        uint64_t programStages[shadersCount]{};             // stageObjects keys of program, 0 unused
+        uint64_t buildingStages[shadersCount]{};            // and of the build
+        GLuint   stageShaders[shadersCount]{};              // of the build, for the logs
+        std::vector<std::string> stageFiles[shadersCount]{};// #line file numbers per stage
+
+        ProgramReflection  reflection{};    // of program
+    };
+
+    bool prepare(const ProgramDesc& desc, ShaderSource (&sources)[shadersCount],
+                 unsigned& stageMask, uint64_t& programHash, std::vector<std::string>& files);
+    void startBuild(Entry& entry, ShaderSource (&sources)[shadersCount], unsigned stageMask, uint64_t programHash);
+    void complete(Entry& entry);
+    void programReady(Entry& entry, GLuint linked);
+    void dropBuild(Entry& entry);
+    void releaseStages();
+
+    std::vector<Entry>  entries{};
+    std::unordered_map<uint64_t, Handle> programHandles{};  // program hash -> entry
+    std::unordered_map<uint64_t, GLuint> stageObjects{};    // stage type + source hash -> shader
+    ShaderPreprocessor  preprocessor{};
+    const ProgramCache* cache{};
+    const ShaderArchive* archive{};
+    GLuint              fallback{};
+    size_t              pendingCount{};
+    bool                parallel{};
+    bool                spirv{};            // glShaderBinary(GL_SHADER_BINARY_FORMAT_SPIR_V) available
+};
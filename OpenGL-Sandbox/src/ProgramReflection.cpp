@@ -0,0 +1,199 @@
+#include "ProgramReflection.h"
+#include "Hash.h"
+
+#include <cctype>
+
+namespace
+{
+    std::string resourceName(GLuint program, GLenum interfaceType, GLuint index)
+    {
+        GLint length{};
+        const GLenum property{ GL_NAME_LENGTH };
+        glGetProgramResourceiv(program, interfaceType, index, 1, &property, 1, NULL, &length);
+
+        std::string name(length > 0 ? length : 1, '\0');
+        glGetProgramResourceName(program, interfaceType, index, static_cast<GLsizei>(name.size()), NULL, &name[0]);
+        name.resize(name.find('\0') == std::string::npos ? name.size() : name.find('\0'));
+        return name;
+    }
+
+    GLint activeResources(GLuint program, GLenum interfaceType)
+    {
+        GLint count{};
+        glGetProgramInterfaceiv(program, interfaceType, GL_ACTIVE_RESOURCES, &count);
+        return count;
+    }
+
+    int find(const std::unordered_map<uint64_t, int>& table, const std::string& name)
+    {
+        auto found = table.find(hashString(name));
+        return found == table.end() ? -1 : found->second;
+    }
+
+    // "0:12(5): error" (Mesa), "0(12) : error" (NVIDIA), "ERROR: 0:12:" (AMD) -> "path:12..."
+    std::string mapSourceNumbers(const std::string& line, const std::vector<std::string>& files)
+    {
+        for (size_t start = 0; start < line.size(); start++)
+        {
+            if (!isdigit(static_cast<unsigned char>(line[start])) || (start && isalnum(static_cast<unsigned char>(line[start - 1]))))
+                continue;
+
+            size_t end{ start };
+            while (end < line.size() && isdigit(static_cast<unsigned char>(line[end])))
+                end++;
+            if (end + 1 >= line.size() || (line[end] != ':' && line[end] != '(') ||
+                !isdigit(static_cast<unsigned char>(line[end + 1])))
+                return line;
+
+            size_t file{ static_cast<size_t>(std::stoul(line.substr(start, end - start))) };
+            if (file >= files.size())
+                return line;
+
+            size_t numberEnd{ end + 1 };
+            while (numberEnd < line.size() && isdigit(static_cast<unsigned char>(line[numberEnd])))
+                numberEnd++;
+            size_t rest{ numberEnd };
+            if (line[end] == '(' && rest < line.size() && line[rest] == ')')
+                rest++;
+            return line.substr(0, start) + files[file] + ":" + line.substr(end + 1, numberEnd - end - 1) + line.substr(rest);
+        }
+        return line;
+    }
+}
+
+void ProgramReflection::clear()
+{
+    uniforms.clear();
+    blocks.clear();
+    inputs.clear();
+    uniformByName.clear();
+    blockByName.clear();
+    inputByName.clear();
+}
+
+void ProgramReflection::reflect(GLuint program)
+{
+    clear();
+
+    GLint uniformCount{ activeResources(program, GL_UNIFORM) };
+    for (GLint i = 0; i < uniformCount; i++)
+    {
+        const GLenum properties[] = { GL_LOCATION, GL_TYPE, GL_ARRAY_SIZE, GL_BLOCK_INDEX };
+        GLint values[4]{};
+        glGetProgramResourceiv(program, GL_UNIFORM, i, 4, properties, 4, NULL, values);
+
+        ReflectedUniform uniform{ resourceName(program, GL_UNIFORM, i), values[0], static_cast<GLenum>(values[1]),
+                                  values[2], values[3] };
+        int index{ static_cast<int>(uniforms.size()) };
+        uniformByName[hashString(uniform.name)] = index;
+
+        // Arrays are reported as "name[0]", make plain "name" work too
+        size_t bracket{ uniform.name.find("[0]") };
+        if (bracket != std::string::npos && bracket + 3 == uniform.name.size())
+            uniformByName[hashString(uniform.name.substr(0, bracket))] = index;
+        uniforms.push_back(uniform);
+    }
+
+    const GLenum blockInterfaces[] = { GL_UNIFORM_BLOCK, GL_SHADER_STORAGE_BLOCK };
+    for (GLenum interfaceType : blockInterfaces)
+    {
+        GLint blockCount{ activeResources(program, interfaceType) };
+        for (GLint i = 0; i < blockCount; i++)
+        {
+            const GLenum properties[] = { GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE };
+            GLint values[2]{};
+            glGetProgramResourceiv(program, interfaceType, i, 2, properties, 2, NULL, values);
+
+            ReflectedBlock block{ resourceName(program, interfaceType, i), interfaceType, values[0], values[1] };
+            blockByName[hashString(block.name)] = static_cast<int>(blocks.size());
+            blocks.push_back(block);
+        }
+    }
+
+    GLint inputCount{ activeResources(program, GL_PROGRAM_INPUT) };
+    for (GLint i = 0; i < inputCount; i++)
+    {
+        const GLenum properties[] = { GL_LOCATION, GL_TYPE };
+        GLint values[2]{};
+        glGetProgramResourceiv(program, GL_PROGRAM_INPUT, i, 2, properties, 2, NULL, values);
+
+        ReflectedInput input{ resourceName(program, GL_PROGRAM_INPUT, i), values[0], static_cast<GLenum>(values[1]) };
+        inputByName[hashString(input.name)] = static_cast<int>(inputs.size());
+        inputs.push_back(input);
+    }
+}
+
+int ProgramReflection::findUniform(const std::string& name) const
+{
+    return find(uniformByName, name);
+}
+
+int ProgramReflection::findBlock(const std::string& name) const
+{
+    return find(blockByName, name);
+}
+
+int ProgramReflection::findInput(const std::string& name) const
+{
+    return find(inputByName, name);
+}
+
+bool ProgramReflection::checkLocation(const std::string& name, GLint location) const
+{
+    int index{ findUniform(name) };
+    if (index < 0 || uniforms[index].location == location)
+        return true;
+    fprintf(stderr, "Uniform %s is at location %d, the code sets location %d\n", name.c_str(), uniforms[index].location, location);
+    return false;
+}
+
+void ProgramReflection::print(FILE* out) const
+{
+    for (const ReflectedInput& input : inputs)
+        fprintf(out, "  input   %-24s location %d type 0x%x\n", input.name.c_str(), input.location, input.type);
+    for (const ReflectedUniform& uniform : uniforms)
+        fprintf(out, "  uniform %-24s location %d type 0x%x array %d block %d\n", uniform.name.c_str(),
+                uniform.location, uniform.type, uniform.arraySize, uniform.blockIndex);
+    for (const ReflectedBlock& block : blocks)
+        fprintf(out, "  %s %-24s binding %d size %d\n", block.interfaceType == GL_UNIFORM_BLOCK ? "ubo    " : "ssbo   ",
+                block.name.c_str(), block.binding, block.dataSize);
+}
+
+bool reportCompileLog(GLuint shader, const std::vector<std::string>& files)
+{
+    GLint compiled{}, length{};
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &compiled);
+    glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+    if (length > 1)
+    {
+        std::string log(length, '\0');
+        glGetShaderInfoLog(shader, length, NULL, &log[0]);
+
+        size_t start{};
+        while (start < log.size() && log[start] != '\0')
+        {
+            size_t end{ log.find('\n', start) };
+            if (end == std::string::npos)
+                end = log.find('\0', start) == std::string::npos ? log.size() : log.find('\0', start);
+            std::string line{ log.substr(start, end - start) };
+            if (!line.empty())
+                fprintf(stderr, "%s\n", mapSourceNumbers(line, files).c_str());
+            start = end + 1;
+        }
+    }
+    return compiled != 0;
+}
+
+bool reportLinkLog(GLuint program, const std::string& name)
+{
+    GLint linked{}, length{};
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    glGetProgramiv(program, GL_INFO_LOG_LENGTH, &length);
+    if (length > 1)
+    {
+        std::string log(length, '\0');
+        glGetProgramInfoLog(program, length, NULL, &log[0]);
+        fprintf(stderr, "%s link log:\n%s\n", name.c_str(), log.c_str());
+    }
+    return linked != 0;
+}
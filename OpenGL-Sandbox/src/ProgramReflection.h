@@ -0,0 +1,69 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct ReflectedUniform
+{
+    std::string name{};
+    GLint       location{ -1 };  // -1 for members of uniform/storage blocks
+    GLenum      type{};
+    GLint       arraySize{};
+    GLint       blockIndex{ -1 };
+};
+
+struct ReflectedBlock
+{
+    std::string name{};
+    GLenum      interfaceType{}; // GL_UNIFORM_BLOCK or GL_SHADER_STORAGE_BLOCK
+    GLint       binding{};
+    GLint       dataSize{};
+};
+
+struct ReflectedInput
+{
+    std::string name{};
+    GLint       location{ -1 };
+    GLenum      type{};
+};
+
+// Everything a linked program exposes, read once after link through
+// glGetProgramInterfaceiv / glGetProgramResourceiv. Lookups by name go through a
+// hash table; per-frame code should resolve names once and keep the indices.
+class ProgramReflection
+{
+public:
+    void reflect(GLuint program);
+    void clear();
+
+    int findUniform(const std::string& name) const; // index into uniforms, -1 if inactive
+    int findBlock(const std::string& name) const;   // index into blocks, -1 if inactive
+    int findInput(const std::string& name) const;   // index into inputs, -1 if inactive
+
+    // For uniforms the C++ side sets at a fixed layout (location): false, after saying so,
+    // when name is active somewhere else. SPIR-V programs may carry no names, those pass.
+    bool checkLocation(const std::string& name, GLint location) const;
+
+    void print(FILE* out) const;
+
+    std::vector<ReflectedUniform>   uniforms{};
+    std::vector<ReflectedBlock>     blocks{};
+    std::vector<ReflectedInput>     inputs{};
+
+private:
+    std::unordered_map<uint64_t, int> uniformByName{};
+    std::unordered_map<uint64_t, int> blockByName{};
+    std::unordered_map<uint64_t, int> inputByName{};
+};
+
+// Prints the compile log of a stage object with "N(line)" / "N:line" source string
+// numbers replaced by the file names from the preprocessor. Returns GL_COMPILE_STATUS.
+bool reportCompileLog(GLuint shader, const std::vector<std::string>& files);
+
+// Prints the link log if there is one. Returns GL_LINK_STATUS.
+bool reportLinkLog(GLuint program, const std::string& name);
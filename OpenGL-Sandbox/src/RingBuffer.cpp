@@ -0,0 +1,94 @@
+#include "RingBuffer.h"
+
+#include <algorithm>
+#include <cstdio>
+
+bool RingBuffer::init(GLsizeiptr regionBytes, int frameCount)
+{
+    shutdown();
+
+    GLint alignment{};
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    uniformAlignment = std::max<GLsizeiptr>(alignment, 16);
+
+    // Regions start on the uniform alignment so an offset of 0 is valid for any binding
+    regions = std::min(std::max(frameCount, 1), maxFrames);
+    regionSize = (regionBytes + uniformAlignment - 1) / uniformAlignment * uniformAlignment;
+    const GLbitfield flags{ GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT };
+    glCreateBuffers(1, &name);
+    glNamedBufferStorage(name, regionSize * regions, nullptr, flags);
+    mapping = static_cast<char*>(glMapNamedBufferRange(name, 0, regionSize * regions, flags));
+    if (!mapping)
+    {
+        fprintf(stderr, "Can't map the %lld byte streaming ring\n", static_cast<long long>(regionSize * regions));
+        shutdown();
+        return false;
+    }
+    current = 0;
+    head = 0;
+    return true;
+}
+
+void RingBuffer::shutdown()
+{
+    for (GLsync& fence : fences)
+    {
+        if (fence)
+            glDeleteSync(fence);
+        fence = nullptr;
+    }
+    if (name)
+    {
+        glUnmapNamedBuffer(name);
+        glDeleteBuffers(1, &name);
+    }
+    name = 0;
+    mapping = nullptr;
+}
+
+void RingBuffer::beginFrame()
+{
+    head = 0;
+    GLsync& fence{ fences[current] };
+    if (!fence)
+        return;
+
+    // Poll first, only flush and block when the GPU is really still reading this region
+    if (glClientWaitSync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+    {
+        stallCount++;
+        GLenum status{};
+        do
+            status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000); // 1 ms
+        while (status == GL_TIMEOUT_EXPIRED);
+    }
+    glDeleteSync(fence);
+    fence = nullptr;
+}
+
+void RingBuffer::endFrame()
+{
+    if (!name)
+        return;
+    fences[current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    current = (current + 1) % regions;
+}
+
+RingBuffer::Allocation RingBuffer::allocate(GLsizeiptr size, GLsizeiptr alignment)
+{
+    GLsizeiptr start{ (head + alignment - 1) / alignment * alignment };
+    if (!mapping || start + size > regionSize)
+    {
+        if (!warnedFull && mapping)
+            fprintf(stderr, "Streaming ring region of %lld bytes is full\n", static_cast<long long>(regionSize));
+        warnedFull = true;
+        return {};
+    }
+    head = start + size;
+
+    Allocation allocation{};
+    allocation.offset = current * regionSize + start;
+    allocation.data = mapping + allocation.offset;
+    allocation.size = size;
+    return allocation;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+
+// Streaming memory for per-frame data (vertices, uniforms, indirect commands): one
+// persistently mapped, coherent buffer cut into a region per frame in flight. A frame
+// bump-allocates from its region and writes straight into the mapping. endFrame() fences
+// the region, and beginFrame() waits on the fence of the region it is about to reuse,
+// which is normally long signaled. Nothing goes through glBufferSubData or a driver copy.
+class RingBuffer
+{
+public:
+    struct Allocation
+    {
+        void*       data{};     // write only; coherent, so the next draw sees it without a flush
+        GLintptr    offset{};   // into buffer()
+        GLsizeiptr  size{};
+
+        explicit operator bool() const { return data != nullptr; }
+    };
+
+    bool init(GLsizeiptr regionBytes, int frameCount = 3);
+    void shutdown();
+
+    void beginFrame();
+    void endFrame();
+
+    // Empty allocation when the frame's region is used up
+    Allocation allocate(GLsizeiptr size, GLsizeiptr alignment = 16);
+    Allocation allocateUniform(GLsizeiptr size) { return allocate(size, uniformAlignment); }
+
+    GLuint buffer() const { return name; }
+    int stalls() const { return stallCount; }   // beginFrame() calls that had to wait for the GPU
+
+private:
+    static const int maxFrames{ 4 };
+
+    GLuint      name{};
+    char*       mapping{};
+    GLsizeiptr  regionSize{};
+    int         regions{};
+    int         current{};
+    GLsizeiptr  head{};                         // bytes used in the current region
+    GLsync      fences[maxFrames]{};
+    GLsizeiptr  uniformAlignment{ 256 };
+    int         stallCount{};
+    bool        warnedFull{};
+};
@@ -0,0 +1,112 @@
+#include "Shader.h"
+#include "MappedFile.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+bool loadShader(const std::string& filePath, MappedFile& file)
+{
+    if (!file.open(filePath))
+    {
+        fprintf(stderr, "Can't open shader file %s\n", filePath.c_str());
+        return false;
+    }
+    return true;
+};
+
+ProgramDesc defaultProgram(void)
+{
+    ProgramDesc desc =
+    {{
+        {1, GL_VERTEX_SHADER,            "res/shaders/Vertex.glsl"},
+        {0, GL_TESS_CONTROL_SHADER,      "res/shaders/TessellationControl.glsl",     "TESSELLATION"},
+        {0, GL_TESS_EVALUATION_SHADER,   "res/shaders/TessellationEvaluation.glsl",  "TESSELLATION"},
+        {0, GL_GEOMETRY_SHADER,          "res/shaders/Geometry.glsl",                "GEOMETRY_POINTS"},
+        {1, GL_FRAGMENT_SHADER,          "res/shaders/Fragment.glsl"},
+        {0, GL_COMPUTE_SHADER,           "res/shaders/Compute.glsl"}
+    }};
+    return desc;
+};
+
+ProgramDesc computeProgram(const std::string& path)
+{
+    ProgramDesc desc{ defaultProgram() };
+    for (Shader& shader : desc.pipeline)
+    {
+        shader.enabled = shader.type == GL_COMPUTE_SHADER;
+        if (shader.enabled)
+            shader.path = path;
+    }
+    return desc;
+};
+
+std::vector<std::string> computePasses(void)
+{
+    return { "res/shaders/Compute.glsl", "res/shaders/ClusterCulling.glsl", "res/shaders/DepthPyramid.glsl" };
+};
+
+bool isStageEnabled(const ProgramDesc& desc, int stage)
+{
+    const Shader& shader{ desc.pipeline[stage] };
+    if (shader.enabled)
+        return true;
+    if (shader.define.empty())
+        return false;
+
+    for (const std::string& define : desc.defines)
+        if (define.compare(0, define.find('='), shader.define) == 0)
+            return true;
+    return false;
+};
+
+bool isSpirvPath(const std::string& path)
+{
+    return path.size() > 4 && path.compare(path.size() - 4, 4, ".spv") == 0;
+};
+
+std::vector<std::vector<std::string>> readVariantList(const std::string& path)
+{
+    std::vector<std::vector<std::string>> variants{ {} };
+    std::ifstream file(path);
+    std::string line{};
+    while (std::getline(file, line))
+    {
+        line = line.substr(0, line.find('#'));
+        std::istringstream keys(line);
+        std::vector<std::string> defines{ std::istream_iterator<std::string>(keys), std::istream_iterator<std::string>() };
+        if (!defines.empty())
+            variants.push_back(defines);
+    }
+    return variants;
+}
+
+bool specializationOf(const std::string& define, SpecializationConstant& constant)
+{
+    // Key and constant_id as the stages declare them
+    static const struct { const char* key; GLuint id; } specialized[]{
+        { "MAX_TESS_LEVEL", 0 },    // TessellationControl.glsl
+    };
+    size_t equals{ define.find('=') };
+    if (equals == std::string::npos)
+        return false;
+    for (const auto& entry : specialized)
+    {
+        if (define.compare(0, equals, entry.key) == 0)
+        {
+            constant = { entry.id, floatBits(static_cast<float>(atof(define.c_str() + equals + 1))) };
+            return true;
+        }
+    }
+    return false;
+}
+
+GLuint floatBits(float value)
+{
+    GLuint bits{};
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+};
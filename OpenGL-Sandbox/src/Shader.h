@@ -0,0 +1,56 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <string>
+#include <vector>
+
+class MappedFile;
+
+const int shadersCount = 6; // there is 6 shaders in OpenGL pipeline
+
+struct Shader
+{
+    int enabled{};
+    GLenum type{};
+    std::string path{};     // GLSL source, or a SPIR-V module if it ends in .spv
+    std::string define{};   // also enabled when the program defines this key
+};
+
+// layout (constant_id = id) in a SPIR-V module
+struct SpecializationConstant
+{
+    GLuint id{};
+    GLuint value{};         // raw 32 bits, use floatBits() for float constants
+};
+
+// One entry per pipeline stage, in pipeline order, plus the variant's #define keys.
+// GLSL stages see the defines, SPIR-V stages see the specialization constants.
+struct ProgramDesc
+{
+    Shader pipeline[shadersCount]{};
+    std::vector<std::string> defines{};  // "KEY" or "KEY=VALUE"
+    std::vector<SpecializationConstant> constants{};
+};
+
+// Maps the shader file so glShaderSource gets pointer + length without copies.
+// A missing file is reported on stderr and returns false.
+bool loadShader(const std::string& filePath, MappedFile& file);
+
+ProgramDesc defaultProgram(void); // the res/shaders table
+ProgramDesc computeProgram(const std::string& path = "res/shaders/Compute.glsl"); // same table, this compute stage only
+std::vector<std::string> computePasses(void); // compute shaders the app runs on their own
+
+bool isStageEnabled(const ProgramDesc& desc, int stage);
+
+bool isSpirvPath(const std::string& path);
+
+// res/shaders/Variants.txt: one variant per line, its #define keys separated by spaces;
+// '#' starts a comment. The base variant is always first, the manifest is optional.
+std::vector<std::vector<std::string>> readVariantList(const std::string& path = "res/shaders/Variants.txt");
+
+// "KEY=VALUE" defines a SPIR-V module can't see, so they reach it as a float specialization
+// constant instead; GLSL stages still get the define. False for every other define.
+bool specializationOf(const std::string& define, SpecializationConstant& constant);
+
+GLuint floatBits(float value);
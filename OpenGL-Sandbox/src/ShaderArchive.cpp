@@ -0,0 +1,149 @@
+#include "ShaderArchive.h"
+#include "Hash.h"
+#include "ShaderPreprocessor.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+uint64_t ShaderArchive::stageKey(const std::string& path, std::vector<std::string> defines)
+{
+    std::sort(defines.begin(), defines.end());
+    defines.erase(std::unique(defines.begin(), defines.end()), defines.end());
+
+    uint64_t key{ hashString(normalizePath(path)) };
+    for (const std::string& define : defines)
+        key = hashString(define, key);
+    return key;
+}
+
+bool ShaderArchive::open(const std::string& path)
+{
+    entryCount = 0;
+    if (!file.open(path))
+        return false;
+
+    ShaderArchiveHeader header{};
+    if (file.size() < sizeof(header))
+    {
+        file.close();
+        return false;
+    }
+    std::copy(file.data(), file.data() + sizeof(header), reinterpret_cast<char*>(&header));
+    if (header.magic != magic || header.version != version ||
+        file.size() < sizeof(header) + header.entryCount * sizeof(ShaderArchiveEntry))
+    {
+        fprintf(stderr, "%s is not a shader archive of version %u, ignoring it\n", path.c_str(), version);
+        file.close();
+        return false;
+    }
+    entryCount = header.entryCount;
+    return true;
+}
+
+const ShaderArchiveEntry* ShaderArchive::entries() const
+{
+    // Right after the 16 byte header, so 8 byte aligned in the page-aligned mapping
+    return reinterpret_cast<const ShaderArchiveEntry*>(file.data() + sizeof(ShaderArchiveHeader));
+}
+
+// Written so a garbage offset can't wrap around the sum
+bool ShaderArchive::contains(uint64_t offset, uint64_t size) const
+{
+    return size <= file.size() && offset <= file.size() - size;
+}
+
+const ShaderArchiveEntry* ShaderArchive::find(uint64_t key) const
+{
+    if (!entryCount)
+        return nullptr;
+
+    const ShaderArchiveEntry* begin{ entries() };
+    const ShaderArchiveEntry* end{ begin + entryCount };
+    const ShaderArchiveEntry* found{ std::lower_bound(begin, end, key,
+        [](const ShaderArchiveEntry& entry, uint64_t value) { return entry.key < value; }) };
+    return found != end && found->key == key ? found : nullptr;
+}
+
+bool ShaderArchive::fill(const ShaderArchiveEntry& entry, const std::string& path, bool preferSpirv, ShaderSource& out) const
+{
+    out = ShaderSource{};
+    bool useSpirv{ preferSpirv && entry.spirvSize > 0 };
+    uint64_t offset{ useSpirv ? entry.spirvOffset : entry.sourceOffset };
+    uint64_t size{ useSpirv ? entry.spirvSize : entry.sourceSize };
+    if (!contains(offset, size) || !contains(entry.filesOffset, entry.filesSize))
+    {
+        fprintf(stderr, "Shader archive is corrupt, entry of %s points outside the file\n", path.c_str());
+        return false;
+    }
+
+    out.append(file.data() + offset, static_cast<size_t>(size));
+    out.spirv = useSpirv;
+    out.hash = hashBlock(file.data() + offset, static_cast<size_t>(size), out.hash);
+
+    // File names are only needed to translate compiler logs
+    const char* names{ file.data() + entry.filesOffset };
+    const char* namesEnd{ names + entry.filesSize };
+    for (const char* start = names; start < namesEnd;)
+    {
+        const char* stop{ std::find(start, namesEnd, '\n') };
+        out.files.emplace_back(start, stop);
+        start = stop + 1;
+    }
+    if (out.files.empty())
+        out.files.push_back(normalizePath(path));
+    return true;
+}
+
+uint64_t ShaderArchiveWriter::appendBlob(const char* data, size_t size)
+{
+    uint64_t offset{ blob.size() };
+    blob.insert(blob.end(), data, data + size);
+    while (blob.size() % 8)
+        blob.push_back('\0'); // SPIR-V words stay aligned
+    return offset;
+}
+
+void ShaderArchiveWriter::add(uint64_t key, uint32_t stageType, const std::string& source, const std::vector<char>& spirv,
+                              const std::vector<std::string>& files)
+{
+    std::string names{};
+    for (const std::string& name : files)
+        names += (names.empty() ? "" : "\n") + name;
+
+    ShaderArchiveEntry entry{};
+    entry.key = key;
+    entry.stageType = stageType;
+    entry.sourceSize = source.size();
+    entry.sourceOffset = appendBlob(source.data(), source.size());
+    entry.spirvSize = spirv.size();
+    entry.spirvOffset = appendBlob(spirv.data(), spirv.size());
+    entry.filesSize = names.size();
+    entry.filesOffset = appendBlob(names.data(), names.size());
+    entries.push_back(entry);
+}
+
+bool ShaderArchiveWriter::write(const std::string& path)
+{
+    std::sort(entries.begin(), entries.end(),
+              [](const ShaderArchiveEntry& a, const ShaderArchiveEntry& b) { return a.key < b.key; });
+
+    // Offsets so far are relative to the blob, make them relative to the file
+    ShaderArchiveHeader header{ ShaderArchive::magic, ShaderArchive::version, static_cast<uint32_t>(entries.size()) };
+    uint64_t blobStart{ sizeof(header) + entries.size() * sizeof(ShaderArchiveEntry) };
+    std::vector<ShaderArchiveEntry> placed{ entries };
+    for (ShaderArchiveEntry& entry : placed)
+    {
+        entry.sourceOffset += blobStart;
+        entry.spirvOffset += blobStart;
+        entry.filesOffset += blobStart;
+    }
+
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file)
+        return false;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(placed.data()), placed.size() * sizeof(ShaderArchiveEntry));
+    file.write(blob.data(), blob.size());
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MappedFile.h"
+
+struct ShaderSource;
+
+// Packed output of the ShaderBaker tool: for every baked stage variant the expanded
+// GLSL and its SPIR-V. The app maps the whole file once
+// and feeds stages from it, with no file scanning or preprocessing at startup.
+//
+// Layout: header, entries sorted by key, then a blob all offsets point into.
+struct ShaderArchiveHeader
+{
+    uint32_t magic{};
+    uint32_t version{};
+    uint32_t entryCount{};
+    uint32_t reserved{};
+};
+
+struct ShaderArchiveEntry
+{
+    uint64_t key{};             // ShaderArchive::stageKey()
+    uint32_t stageType{};       // GLenum
+    uint32_t reserved{};
+    uint64_t sourceOffset{}, sourceSize{};
+    uint64_t spirvOffset{}, spirvSize{};            // 0 size if not validated
+    uint64_t filesOffset{}, filesSize{};            // '\n' separated #line file names
+};
+
+class ShaderArchive
+{
+public:
+    static const uint32_t magic{ 0x4B415053 };  // "SPAK"
+    static const uint32_t version{ 2 };
+
+    // Stage path + the variant's define keys, in any order
+    static uint64_t stageKey(const std::string& path, std::vector<std::string> defines);
+
+    bool open(const std::string& path);
+    void close() { file.close(); }
+    bool isOpen() const { return file.isOpen(); }
+
+    const ShaderArchiveEntry* find(uint64_t key) const;
+
+    // Points out.strings into the archive; SPIR-V when preferSpirv and baked, else the GLSL.
+    // False when the entry points outside the file, the archive is corrupt.
+    bool fill(const ShaderArchiveEntry& entry, const std::string& path, bool preferSpirv, ShaderSource& out) const;
+
+private:
+    const ShaderArchiveEntry* entries() const;
+    bool contains(uint64_t offset, uint64_t size) const;
+
+    MappedFile  file{};
+    uint32_t    entryCount{};
+};
+
+// Used by the baker: collects stages in memory and writes the archive in one go
+class ShaderArchiveWriter
+{
+public:
+    void add(uint64_t key, uint32_t stageType, const std::string& source, const std::vector<char>& spirv,
+             const std::vector<std::string>& files);
+    bool write(const std::string& path);
+
+private:
+    uint64_t appendBlob(const char* data, size_t size);
+
+    std::vector<ShaderArchiveEntry> entries{};
+    std::vector<char>               blob{};
+};
@@ -0,0 +1,361 @@
+#include "ShaderPreprocessor.h"
+#include "Hash.h"
+#include "Shader.h"
+
+#include <cstdio>
+#include <utility>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+namespace
+{
+    const char newline[] = "\n";
+
+    bool modifiedTime(const std::string& path, int64_t& modified)
+    {
+#ifdef _WIN32
+        struct _stat64 info{};
+        if (_stat64(path.c_str(), &info) != 0)
+            return false;
+#else
+        struct stat info{};
+        if (stat(path.c_str(), &info) != 0)
+            return false;
+#endif
+        modified = static_cast<int64_t>(info.st_mtime);
+        return true;
+    }
+
+    std::string directoryOf(const std::string& path)
+    {
+        size_t slash{ path.find_last_of("/\\") };
+        return slash == std::string::npos ? std::string{} : path.substr(0, slash + 1);
+    }
+
+    bool startsWith(const char* begin, const char* end, const char* word)
+    {
+        for (; *word; word++, begin++)
+            if (begin == end || *begin != *word)
+                return false;
+        return true;
+    }
+
+    const char* skipBlanks(const char* begin, const char* end)
+    {
+        while (begin != end && (*begin == ' ' || *begin == '\t'))
+            begin++;
+        return begin;
+    }
+
+    // Offset just past the newline of the "#version" line, npos if there is none
+    size_t findVersionLineEnd(const char* text, size_t size)
+    {
+        const char* end{ text + size };
+        for (const char* lineStart = text; lineStart != end;)
+        {
+            const char* lineEnd{ lineStart };
+            while (lineEnd != end && *lineEnd != '\n')
+                lineEnd++;
+
+            const char* cursor{ skipBlanks(lineStart, lineEnd) };
+            if (cursor != lineEnd && *cursor == '#' && startsWith(skipBlanks(cursor + 1, lineEnd), lineEnd, "version"))
+                return lineEnd == end ? size : static_cast<size_t>(lineEnd + 1 - text);
+            lineStart = lineEnd == end ? end : lineEnd + 1;
+        }
+        return std::string::npos;
+    }
+}
+
+std::string normalizePath(const std::string& path)
+{
+    std::vector<std::string> parts{};
+    std::string part{};
+    for (size_t i = 0; i <= path.size(); i++)
+    {
+        if (i == path.size() || path[i] == '/' || path[i] == '\\')
+        {
+            if (part == "..")
+            {
+                if (!parts.empty() && parts.back() != "..")
+                    parts.pop_back();
+                else
+                    parts.push_back(part);
+            }
+            else if (!part.empty() && part != ".")
+            {
+                parts.push_back(part);
+            }
+            part.clear();
+        }
+        else
+        {
+            part += path[i];
+        }
+    }
+
+    std::string normalized{ !path.empty() && (path[0] == '/' || path[0] == '\\') ? "/" : "" };
+    for (size_t i = 0; i < parts.size(); i++)
+    {
+        if (i)
+            normalized += '/';
+        normalized += parts[i];
+    }
+    return normalized;
+}
+
+std::string ShaderSource::text() const
+{
+    std::string result{};
+    for (size_t i = 0; i < strings.size(); i++)
+        result.append(strings[i], lengths[i]);
+    return result;
+}
+
+void ShaderSource::append(const char* data, size_t size)
+{
+    if (!size)
+        return;
+    strings.push_back(data);
+    lengths.push_back(static_cast<int>(size));
+}
+
+void ShaderSource::appendGenerated(std::string line)
+{
+    generated.push_back(std::move(line));
+    append(generated.back().data(), generated.back().size());
+}
+
+ShaderPreprocessor::ShaderPreprocessor()
+{
+    addIncludeDirectory("res/shaders");
+}
+
+void ShaderPreprocessor::addIncludeDirectory(const std::string& directory)
+{
+    includeDirectories.push_back(normalizePath(directory) + "/");
+}
+
+void ShaderPreprocessor::invalidate(const std::string& path)
+{
+    chunks.erase(normalizePath(path));
+}
+
+void ShaderPreprocessor::clear()
+{
+    chunks.clear();
+}
+
+ShaderPreprocessor::Chunk* ShaderPreprocessor::getChunk(const std::string& path)
+{
+    int64_t modified{};
+    bool exists{ modifiedTime(path, modified) };
+
+    auto found = chunks.find(path);
+    if (found != chunks.end())
+    {
+        if (exists && found->second->modified == modified)
+            return found->second.get();
+        chunks.erase(found);
+    }
+
+    std::unique_ptr<Chunk> chunk{ new Chunk{} };
+    if (!loadShader(path, chunk->file))
+        return nullptr;
+    chunk->modified = modified;
+
+    // Split into text runs and directives, one pass over the mapped bytes.
+    // SPIR-V modules are binary and stay one piece.
+    const char* begin{ chunk->file.data() };
+    const char* end{ begin + chunk->file.size() };
+    const char* textStart{ begin };
+    int line{ 1 };
+    for (const char* lineStart = isSpirvPath(path) ? end : begin; lineStart != end; line++)
+    {
+        const char* lineEnd{ lineStart };
+        while (lineEnd != end && *lineEnd != '\n')
+            lineEnd++;
+        const char* next{ lineEnd == end ? end : lineEnd + 1 };
+
+        const char* cursor{ skipBlanks(lineStart, lineEnd) };
+        if (cursor != lineEnd && *cursor == '#')
+        {
+            cursor = skipBlanks(cursor + 1, lineEnd);
+
+            Piece directive{};
+            bool matched{};
+            if (startsWith(cursor, lineEnd, "include"))
+            {
+                cursor = skipBlanks(cursor + 7, lineEnd);
+                char close{ cursor != lineEnd && *cursor == '<' ? '>' : '"' };
+                if (cursor != lineEnd && (*cursor == '"' || *cursor == '<'))
+                {
+                    const char* nameEnd{ cursor + 1 };
+                    while (nameEnd != lineEnd && *nameEnd != close)
+                        nameEnd++;
+                    directive.type = PieceType::Include;
+                    directive.include.assign(cursor + 1, nameEnd);
+                    directive.line = line;
+                    matched = true;
+                }
+            }
+            else if (startsWith(cursor, lineEnd, "pragma"))
+            {
+                cursor = skipBlanks(cursor + 6, lineEnd);
+                if (startsWith(cursor, lineEnd, "once"))
+                {
+                    chunk->pragmaOnce = true;
+                    directive.type = PieceType::Newline; // keeps the line count
+                    matched = true;
+                }
+            }
+
+            if (matched)
+            {
+                if (lineStart != textStart)
+                    chunk->pieces.push_back({ PieceType::Text, static_cast<size_t>(textStart - begin),
+                                              static_cast<size_t>(lineStart - textStart) });
+                chunk->pieces.push_back(directive);
+                textStart = next;
+            }
+        }
+        lineStart = next;
+    }
+    if (textStart != end)
+        chunk->pieces.push_back({ PieceType::Text, static_cast<size_t>(textStart - begin),
+                                  static_cast<size_t>(end - textStart) });
+
+    Chunk* result{ chunk.get() };
+    chunks[path] = std::move(chunk);
+    return result;
+}
+
+std::string ShaderPreprocessor::resolve(const std::string& includingPath, const std::string& name) const
+{
+    int64_t modified{};
+    std::string candidate{ normalizePath(directoryOf(includingPath) + name) };
+    if (modifiedTime(candidate, modified))
+        return candidate;
+
+    for (const std::string& directory : includeDirectories)
+    {
+        candidate = normalizePath(directory + name);
+        if (modifiedTime(candidate, modified))
+            return candidate;
+    }
+    return {};
+}
+
+bool ShaderPreprocessor::expand(const std::string& path, int fileId, ShaderSource& out, std::string& pendingDefines,
+                                std::vector<std::string>& stack, std::unordered_set<std::string>& included)
+{
+    Chunk* chunk{ getChunk(path) };
+    if (!chunk)
+        return false;
+
+    stack.push_back(path);
+    included.insert(path);
+
+    for (const Piece& piece : chunk->pieces)
+    {
+        if (piece.type == PieceType::Text)
+        {
+            const char* text{ chunk->file.data() + piece.offset };
+            size_t split{ pendingDefines.empty() ? std::string::npos : findVersionLineEnd(text, piece.size) };
+            if (split != std::string::npos)
+            {
+                // #version has to stay first, defines go right after it
+                int nextLine{ 1 };
+                for (const char* c = chunk->file.data(); c != text + split; c++)
+                    nextLine += *c == '\n';
+                out.append(text, split);
+                std::string separator{ text[split - 1] == '\n' ? "" : "\n" };
+                out.appendGenerated(separator + pendingDefines + "#line " + std::to_string(nextLine) + " 0\n");
+                out.append(text + split, piece.size - split);
+                pendingDefines.clear();
+            }
+            else
+            {
+                out.append(text, piece.size);
+            }
+            continue;
+        }
+        if (piece.type == PieceType::Newline)
+        {
+            out.append(newline, 1);
+            continue;
+        }
+
+        std::string includePath{ resolve(path, piece.include) };
+        if (includePath.empty())
+        {
+            fprintf(stderr, "%s:%d: can't find include \"%s\"\n", path.c_str(), piece.line, piece.include.c_str());
+            return false;
+        }
+        for (const std::string& open : stack)
+        {
+            if (open == includePath)
+            {
+                fprintf(stderr, "%s:%d: recursive include of %s\n", path.c_str(), piece.line, includePath.c_str());
+                return false;
+            }
+        }
+
+        // Already expanded in this pass: don't re-stat, earlier pieces point into its mapping
+        Chunk* child{ included.count(includePath) ? chunks[includePath].get() : getChunk(includePath) };
+        if (!child)
+            return false;
+        if (child->pragmaOnce && included.count(includePath))
+        {
+            out.append(newline, 1);
+            continue;
+        }
+
+        int childId{ static_cast<int>(out.files.size()) };
+        out.files.push_back(includePath);
+        // GLSL 3.30+: the line after "#line N" is line N
+        out.appendGenerated("#line 1 " + std::to_string(childId) + "\n");
+        std::string noDefines{};
+        if (!expand(includePath, childId, out, noDefines, stack, included))
+            return false;
+        if (child->file.size() && child->file.data()[child->file.size() - 1] != '\n')
+            out.append(newline, 1);
+        out.appendGenerated("#line " + std::to_string(piece.line + 1) + " " + std::to_string(fileId) + "\n");
+    }
+
+    stack.pop_back();
+    return true;
+}
+
+bool ShaderPreprocessor::process(const std::string& path, ShaderSource& out, const std::vector<std::string>& defines)
+{
+    out = ShaderSource{};
+    std::string root{ normalizePath(path) };
+    out.files.push_back(root);
+    out.spirv = isSpirvPath(root);
+
+    std::string pendingDefines{};
+    for (const std::string& define : out.spirv ? std::vector<std::string>{} : defines)
+    {
+        size_t equals{ define.find('=') };
+        pendingDefines += "#define " + (equals == std::string::npos ? define + " 1" :
+                                        define.substr(0, equals) + " " + define.substr(equals + 1)) + "\n";
+    }
+
+    std::vector<std::string> stack{};
+    std::unordered_set<std::string> included{};
+    if (!expand(root, 0, out, pendingDefines, stack, included))
+        return false;
+
+    if (!pendingDefines.empty())
+    {
+        // No #version in the root file: defines go first, numbering restarts at line 1
+        out.generated.push_back(pendingDefines + "#line 1 0\n");
+        out.strings.insert(out.strings.begin(), out.generated.back().data());
+        out.lengths.insert(out.lengths.begin(), static_cast<int>(out.generated.back().size()));
+    }
+
+    for (int i = 0; i < out.count(); i++)
+        out.hash = hashBlock(out.strings[i], out.lengths[i], out.hash);
+
+    return true;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "Hash.h"
+#include "MappedFile.h"
+
+// Preprocessed shader, ready for glShaderSource(shader, count(), strings(), lengths()).
+// The strings point into the preprocessor's mapped files, so the source is only
+// valid while the ShaderPreprocessor that produced it is alive and unchanged.
+struct ShaderSource
+{
+    std::vector<const char*>    strings{};
+    std::vector<int>            lengths{};
+    std::vector<std::string>    files{};    // #line source-string-number -> path, root file is 0
+    std::deque<std::string>     generated{};// #line directives, deque keeps pointers stable
+    uint64_t                    hash{ hashSeed };   // over the final text, includes and defines
+    bool                        spirv{};            // one binary SPIR-V module instead of GLSL
+
+    int count() const { return static_cast<int>(strings.size()); }
+    std::string text() const;               // everything concatenated, for tools and logs
+
+    void append(const char* data, size_t size);
+    void appendGenerated(std::string line);
+};
+
+// "res/shaders/./lib/../Common.glsl" -> "res/shaders/Common.glsl", '\\' -> '/'
+std::string normalizePath(const std::string& path);
+
+// Resolves #include "file" / <file> and #pragma once in GLSL. A .spv module is
+// passed through untouched as a single piece, without defines. Every file is mapped and
+// split into chunks once, then reused until its modification time changes, so programs
+// sharing headers don't re-read them. Included text is wrapped in #line directives,
+// so "1(12)" in a compiler log means line 12 of files[1].
+class ShaderPreprocessor
+{
+public:
+    ShaderPreprocessor();
+
+    void addIncludeDirectory(const std::string& directory);
+
+    // defines are "KEY" or "KEY=VALUE", emitted as #define lines right after #version.
+    // Returns false on a missing file or an include cycle.
+    bool process(const std::string& path, ShaderSource& out, const std::vector<std::string>& defines = {});
+
+    void invalidate(const std::string& path);   // drop one cached file
+    void clear();                               // drop all cached files
+
+private:
+    enum class PieceType { Text, Newline, Include };
+
+    struct Piece
+    {
+        PieceType   type{};
+        size_t      offset{};
+        size_t      size{};
+        std::string include{};  // as written, resolved at expansion time
+        int         line{};     // 1-based line of the directive
+    };
+
+    struct Chunk
+    {
+        MappedFile          file{};
+        int64_t             modified{};
+        bool                pragmaOnce{};
+        std::vector<Piece>  pieces{};
+    };
+
+    Chunk* getChunk(const std::string& path);
+    std::string resolve(const std::string& includingPath, const std::string& name) const;
+    bool expand(const std::string& path, int fileId, ShaderSource& out, std::string& pendingDefines,
+                std::vector<std::string>& stack, std::unordered_set<std::string>& included);
+
+    std::vector<std::string>                                includeDirectories{};
+    std::unordered_map<std::string, std::unique_ptr<Chunk>> chunks{};
+};
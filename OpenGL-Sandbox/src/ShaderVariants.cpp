@@ -0,0 +1,44 @@
+#include "ShaderVariants.h"
+#include "Hash.h"
+
+#include <algorithm>
+
+void ShaderVariants::init(ProgramQueue* programQueue, const ProgramDesc& baseDesc)
+{
+    queue = programQueue;
+    base = baseDesc;
+    variants.clear();
+}
+
+ProgramQueue::Handle ShaderVariants::get(std::vector<std::string> defines)
+{
+    defines.insert(defines.end(), base.defines.begin(), base.defines.end());
+    std::sort(defines.begin(), defines.end());
+    defines.erase(std::unique(defines.begin(), defines.end()), defines.end());
+
+    uint64_t key{ hashSeed };
+    for (const std::string& define : defines)
+        key = hashString(define, key);
+
+    auto found = variants.find(key);
+    if (found != variants.end())
+        return found->second;
+
+    ProgramDesc desc{ base };
+    for (const std::string& define : defines)
+    {
+        SpecializationConstant constant{};
+        if (specializationOf(define, constant))
+            desc.constants.push_back(constant);
+    }
+    desc.defines = std::move(defines);
+    ProgramQueue::Handle handle{ queue->submit(desc) };
+    variants[key] = handle;
+    return handle;
+}
+
+void ShaderVariants::warmUp(const std::vector<std::vector<std::string>>& variantList)
+{
+    for (const std::vector<std::string>& defines : variantList)
+        get(defines);
+}
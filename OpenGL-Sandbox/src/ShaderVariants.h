@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ProgramQueue.h"
+#include "Shader.h"
+
+// A base program plus #define keys. Every distinct key set is one variant; keys are
+// sorted and deduplicated first, so {"B", "A"} and {"A", "B"} share a program.
+// Keys specializationOf() knows also become the program's specialization constants.
+// Only variants that are asked for, or listed in warmUp(), are ever compiled.
+class ShaderVariants
+{
+public:
+    void init(ProgramQueue* programQueue, const ProgramDesc& baseDesc);
+
+    ProgramQueue::Handle get(std::vector<std::string> defines);
+    void warmUp(const std::vector<std::vector<std::string>>& variantList);
+
+    size_t size() const { return variants.size(); }
+
+private:
+    ProgramQueue*   queue{};
+    ProgramDesc     base{};
+    std::unordered_map<uint64_t, ProgramQueue::Handle> variants{}; // key set hash -> program
+};
@@ -0,0 +1,165 @@
+#include "ShaderWatcher.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+bool ShaderWatcher::init(const std::string& directory)
+{
+    root = directory;
+    notification = FindFirstChangeNotificationA(directory.c_str(), TRUE,
+                                                FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+    if (notification == INVALID_HANDLE_VALUE)
+    {
+        notification = nullptr;
+        fprintf(stderr, "Can't watch %s for changes\n", directory.c_str());
+        return false;
+    }
+    scan(root, nullptr);
+    return true;
+}
+
+void ShaderWatcher::shutdown()
+{
+    if (notification)
+        FindCloseChangeNotification(notification);
+    notification = nullptr;
+    modified.clear();
+}
+
+void ShaderWatcher::scan(const std::string& directory, std::vector<std::string>* changed)
+{
+    WIN32_FIND_DATAA found{};
+    HANDLE search{ FindFirstFileA((directory + "/*").c_str(), &found) };
+    if (search == INVALID_HANDLE_VALUE)
+        return;
+
+    do
+    {
+        std::string name{ found.cFileName };
+        if (name == "." || name == "..")
+            continue;
+
+        std::string path{ directory + "/" + name };
+        if (found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)
+        {
+            scan(path, changed);
+            continue;
+        }
+
+        int64_t writeTime{ static_cast<int64_t>(found.ftLastWriteTime.dwHighDateTime) << 32 |
+                           found.ftLastWriteTime.dwLowDateTime };
+        int64_t& known{ modified[path] };
+        if (changed && known != writeTime)
+            changed->push_back(path);
+        known = writeTime;
+    } while (FindNextFileA(search, &found));
+    FindClose(search);
+}
+
+std::vector<std::string> ShaderWatcher::poll()
+{
+    std::vector<std::string> changed{};
+    if (!notification || WaitForSingleObject(notification, 0) != WAIT_OBJECT_0)
+        return changed;
+
+    FindNextChangeNotification(notification);
+    scan(root, &changed);
+    return changed;
+}
+
+#else
+
+bool ShaderWatcher::init(const std::string& directory)
+{
+    root = directory;
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd < 0)
+    {
+        fprintf(stderr, "Can't watch %s for changes: inotify unavailable\n", directory.c_str());
+        return false;
+    }
+    watch(root);
+    return true;
+}
+
+void ShaderWatcher::shutdown()
+{
+    if (inotifyFd >= 0)
+        close(inotifyFd);
+    inotifyFd = -1;
+    directories.clear();
+}
+
+void ShaderWatcher::watch(const std::string& directory)
+{
+    // Editors save in place (close after write) or via a temporary file renamed over the original
+    int wd{ inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) };
+    if (wd < 0)
+        return;
+    directories[wd] = directory;
+
+    DIR* dir{ opendir(directory.c_str()) };
+    if (!dir)
+        return;
+    while (dirent* item = readdir(dir))
+    {
+        std::string name{ item->d_name };
+        if (item->d_type == DT_DIR && name != "." && name != "..")
+            watch(directory + "/" + name);
+    }
+    closedir(dir);
+}
+
+std::vector<std::string> ShaderWatcher::poll()
+{
+    std::vector<std::string> changed{};
+    if (inotifyFd < 0)
+        return changed;
+
+    alignas(inotify_event) char buffer[4096];
+    for (;;)
+    {
+        ssize_t length{ read(inotifyFd, buffer, sizeof(buffer)) };
+        if (length <= 0)
+            break; // EAGAIN: nothing more queued
+
+        for (char* cursor = buffer; cursor < buffer + length;)
+        {
+            const inotify_event* event{ reinterpret_cast<const inotify_event*>(cursor) };
+            cursor += sizeof(inotify_event) + event->len;
+
+            auto directory = directories.find(event->wd);
+            if (directory == directories.end() || !event->len)
+                continue;
+
+            std::string path{ directory->second + "/" + event->name };
+            if (event->mask & IN_ISDIR)
+            {
+                if (event->mask & IN_CREATE)
+                    watch(path);
+                continue;
+            }
+            if (event->mask & IN_CREATE)
+                continue; // the matching IN_CLOSE_WRITE follows once the file is written
+            changed.push_back(path);
+        }
+    }
+
+    std::sort(changed.begin(), changed.end());
+    changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+    return changed;
+}
+
+#endif
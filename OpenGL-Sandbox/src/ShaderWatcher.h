@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Watches a shader directory (and its subdirectories) for saved files.
+// Linux uses inotify; Windows waits on a change notification and then compares
+// modification times. poll() never blocks, call it once per frame.
+class ShaderWatcher
+{
+public:
+    bool init(const std::string& directory = "res/shaders");
+    void shutdown();
+
+    std::vector<std::string> poll(); // files changed since the last call, "res/shaders/X.glsl"
+
+private:
+#ifdef _WIN32
+    void scan(const std::string& directory, std::vector<std::string>* changed);
+
+    void*           notification{};                     // HANDLE
+    std::unordered_map<std::string, int64_t> modified{}; // path -> last write time
+#else
+    void watch(const std::string& directory);
+
+    int             inotifyFd{ -1 };
+    std::unordered_map<int, std::string> directories{}; // watch descriptor -> directory
+#endif
+    std::string     root{};
+};
@@ -0,0 +1,519 @@
+// glm declares its SSE2 matrix functions only with intrinsics enabled; the types keep their layout
+#define GLM_FORCE_INTRINSICS
+#include "SoftwareRasterizer.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include <glm/simd/matrix.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#else
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    const int   subpixelBits{ 4 };
+    const int   subpixels{ 1 << subpixelBits };
+    const int   blockSize{ 8 };             // pixels per SIMD row and per hierarchical depth cell
+    const int   maxTargetSize{ 4096 };
+    const float guardBand{ 2048.0f };       // pixels past the target that need no clipping
+    // Edge values at a block origin are clamped to this: with the guard band a block changes an
+    // edge by less than 2^27, so a clamped edge still has one sign over the whole block
+    const int64_t edgeLimit{ int64_t(1) << 30 };
+
+    // Eight lanes of the edge functions and depths: one AVX2 register, or two SSE2 ones
+#if defined(__AVX2__)
+    struct Int8 { __m256i v; };
+    struct Float8 { __m256 v; };
+
+    inline Int8 splat(int32_t value) { return { _mm256_set1_epi32(value) }; }
+    inline Int8 ramp(int32_t step) { return { _mm256_setr_epi32(0, step, 2 * step, 3 * step, 4 * step, 5 * step, 6 * step, 7 * step) }; }
+    inline Int8 operator+(Int8 x, Int8 y) { return { _mm256_add_epi32(x.v, y.v) }; }
+    inline Int8 operator|(Int8 x, Int8 y) { return { _mm256_or_si256(x.v, y.v) }; }
+    inline Float8 nonNegative(Int8 x) { return { _mm256_castsi256_ps(_mm256_cmpgt_epi32(x.v, _mm256_set1_epi32(-1))) }; }
+
+    inline Float8 splat(float value) { return { _mm256_set1_ps(value) }; }
+    inline Float8 ramp(float step) { return { _mm256_mul_ps(_mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_ps(step)) }; }
+    inline Float8 operator+(Float8 x, Float8 y) { return { _mm256_add_ps(x.v, y.v) }; }
+    inline Float8 operator&(Float8 x, Float8 y) { return { _mm256_and_ps(x.v, y.v) }; }
+    inline Float8 less(Float8 x, Float8 y) { return { _mm256_cmp_ps(x.v, y.v, _CMP_LT_OQ) }; }
+    inline Float8 max(Float8 x, Float8 y) { return { _mm256_max_ps(x.v, y.v) }; }
+    inline Float8 select(Float8 mask, Float8 x, Float8 y) { return { _mm256_blendv_ps(y.v, x.v, mask.v) }; }
+    inline bool any(Float8 mask) { return _mm256_movemask_ps(mask.v) != 0; }
+    inline Float8 load(const float* p) { return { _mm256_loadu_ps(p) }; }
+    inline void store(float* p, Float8 x) { _mm256_storeu_ps(p, x.v); }
+    inline Float8 load(const uint32_t* p) { return { _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))) }; }
+    inline void store(uint32_t* p, Float8 x) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), _mm256_castps_si256(x.v)); }
+    inline Float8 splatBits(uint32_t bits) { return { _mm256_castsi256_ps(_mm256_set1_epi32(static_cast<int32_t>(bits))) }; }
+    inline float reduceMax(Float8 x)
+    {
+        __m128 m{ _mm_max_ps(_mm256_castps256_ps128(x.v), _mm256_extractf128_ps(x.v, 1)) };
+        m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+        return _mm_cvtss_f32(_mm_max_ss(m, _mm_shuffle_ps(m, m, 1)));
+    }
+#else
+    struct Int8 { __m128i lo, hi; };
+    struct Float8 { __m128 lo, hi; };
+
+    inline Int8 splat(int32_t value) { return { _mm_set1_epi32(value), _mm_set1_epi32(value) }; }
+    inline Int8 ramp(int32_t step) { return { _mm_setr_epi32(0, step, 2 * step, 3 * step), _mm_setr_epi32(4 * step, 5 * step, 6 * step, 7 * step) }; }
+    inline Int8 operator+(Int8 x, Int8 y) { return { _mm_add_epi32(x.lo, y.lo), _mm_add_epi32(x.hi, y.hi) }; }
+    inline Int8 operator|(Int8 x, Int8 y) { return { _mm_or_si128(x.lo, y.lo), _mm_or_si128(x.hi, y.hi) }; }
+    inline Float8 nonNegative(Int8 x)
+    {
+        const __m128i minusOne{ _mm_set1_epi32(-1) };
+        return { _mm_castsi128_ps(_mm_cmpgt_epi32(x.lo, minusOne)), _mm_castsi128_ps(_mm_cmpgt_epi32(x.hi, minusOne)) };
+    }
+
+    inline Float8 splat(float value) { return { _mm_set1_ps(value), _mm_set1_ps(value) }; }
+    inline Float8 ramp(float step) { return { _mm_setr_ps(0, step, 2 * step, 3 * step), _mm_setr_ps(4 * step, 5 * step, 6 * step, 7 * step) }; }
+    inline Float8 operator+(Float8 x, Float8 y) { return { _mm_add_ps(x.lo, y.lo), _mm_add_ps(x.hi, y.hi) }; }
+    inline Float8 operator&(Float8 x, Float8 y) { return { _mm_and_ps(x.lo, y.lo), _mm_and_ps(x.hi, y.hi) }; }
+    inline Float8 less(Float8 x, Float8 y) { return { _mm_cmplt_ps(x.lo, y.lo), _mm_cmplt_ps(x.hi, y.hi) }; }
+    inline Float8 max(Float8 x, Float8 y) { return { _mm_max_ps(x.lo, y.lo), _mm_max_ps(x.hi, y.hi) }; }
+    inline Float8 select(Float8 mask, Float8 x, Float8 y)
+    {
+        return { _mm_or_ps(_mm_and_ps(mask.lo, x.lo), _mm_andnot_ps(mask.lo, y.lo)),
+                 _mm_or_ps(_mm_and_ps(mask.hi, x.hi), _mm_andnot_ps(mask.hi, y.hi)) };
+    }
+    inline bool any(Float8 mask) { return _mm_movemask_ps(_mm_or_ps(mask.lo, mask.hi)) != 0; }
+    inline Float8 load(const float* p) { return { _mm_loadu_ps(p), _mm_loadu_ps(p + 4) }; }
+    inline void store(float* p, Float8 x) { _mm_storeu_ps(p, x.lo); _mm_storeu_ps(p + 4, x.hi); }
+    inline Float8 load(const uint32_t* p)
+    {
+        return { _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p))),
+                 _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 4))) };
+    }
+    inline void store(uint32_t* p, Float8 x)
+    {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm_castps_si128(x.lo));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(p + 4), _mm_castps_si128(x.hi));
+    }
+    inline Float8 splatBits(uint32_t bits)
+    {
+        __m128 v{ _mm_castsi128_ps(_mm_set1_epi32(static_cast<int32_t>(bits))) };
+        return { v, v };
+    }
+    inline float reduceMax(Float8 x)
+    {
+        __m128 m{ _mm_max_ps(x.lo, x.hi) };
+        m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+        return _mm_cvtss_f32(_mm_max_ss(m, _mm_shuffle_ps(m, m, 1)));
+    }
+#endif
+
+    // Signed distance of a clip space point to one of the clipping planes, >= 0 inside: the near
+    // and far planes, then the guard band around the target
+    float planeDistance(const glm::vec4& p, int plane, const glm::vec2& band)
+    {
+        switch (plane)
+        {
+        case 0: return p.w + p.z;
+        case 1: return p.w - p.z;
+        case 2: return band.x * p.w + p.x;
+        case 3: return band.x * p.w - p.x;
+        case 4: return band.y * p.w + p.y;
+        default: return band.y * p.w - p.y;
+        }
+    }
+}
+
+bool SoftwareRasterizer::init(int width, int height, unsigned threads)
+{
+    if (width <= 0 || height <= 0 || width > maxTargetSize || height > maxTargetSize)
+    {
+        fprintf(stderr, "Software rasterizer: %dx%d is not a supported target size\n", width, height);
+        return false;
+    }
+    targetWidth = width;
+    targetHeight = height;
+    tilesX = (width + tileSize - 1) / tileSize;
+    tilesY = (height + tileSize - 1) / tileSize;
+    pitch = tilesX * tileSize;
+    colorBuffer.assign(size_t(pitch) * tilesY * tileSize, 0);
+    depthBuffer.assign(colorBuffer.size(), 1.0f);
+    blockFarthest.assign(colorBuffer.size() / (blockSize * blockSize), 1.0f);
+
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    stopping = false;
+    for (unsigned i = 1; i < threads; i++)
+        workers.emplace_back(&SoftwareRasterizer::workerLoop, this);
+
+    // A few setup jobs per thread even out uneven draws
+    jobBins.resize(threads * 4);
+    for (Bins& bins : jobBins)
+        bins.tiles.resize(size_t(tilesX) * tilesY);
+    return true;
+}
+
+void SoftwareRasterizer::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& worker : workers)
+        worker.join();
+    workers.clear();
+    jobBins.clear();
+    colorBuffer.clear();
+    depthBuffer.clear();
+    blockFarthest.clear();
+}
+
+void SoftwareRasterizer::setGeometry(const glm::vec3* vertexPositions, GLint vertexStart, const GLuint* indexStream, GLuint indexStart,
+                                     const glm::mat4* instanceModels)
+{
+    positions = vertexPositions;
+    firstVertex = vertexStart;
+    indices = indexStream;
+    firstIndex = indexStart;
+    models = instanceModels;
+}
+
+void SoftwareRasterizer::clear(uint32_t color, float depth)
+{
+    std::fill(colorBuffer.begin(), colorBuffer.end(), color);
+    std::fill(depthBuffer.begin(), depthBuffer.end(), depth);
+    std::fill(blockFarthest.begin(), blockFarthest.end(), depth);
+}
+
+uint64_t SoftwareRasterizer::draw(const DrawElementsIndirectCommand* draws, size_t drawCount, const glm::mat4& viewProjection, uint32_t color)
+{
+    uint64_t triangleCount{};
+    for (size_t i = 0; i < drawCount; i++)
+        triangleCount += uint64_t(draws[i].count / 3) * draws[i].instanceCount;
+    if (triangleCount == 0 || !positions || !indices || !models)
+        return 0;
+
+    unsigned jobs{ static_cast<unsigned>(jobBins.size()) };
+    parallelFor(jobs, [&](unsigned job) { setupJob(job, draws, drawCount, triangleCount, viewProjection, color); });
+    parallelFor(static_cast<unsigned>(tilesX * tilesY), [&](unsigned tile) { rasterizeTile(tile); });
+
+    uint64_t rasterized{};
+    for (const Bins& bins : jobBins)
+        rasterized += bins.triangleCount;
+    return rasterized;
+}
+
+void SoftwareRasterizer::readPixels(std::vector<uint32_t>& pixels) const
+{
+    pixels.resize(size_t(targetWidth) * targetHeight);
+    for (int y = 0; y < targetHeight; y++)
+        std::copy_n(colorBuffer.begin() + size_t(y) * pitch, targetWidth, pixels.begin() + size_t(y) * targetWidth);
+}
+
+// Job j sets up its share of the triangles of all draws, flattened in submission order
+void SoftwareRasterizer::setupJob(unsigned job, const DrawElementsIndirectCommand* draws, size_t drawCount, uint64_t triangleCount,
+                                  const glm::mat4& viewProjection, uint32_t color)
+{
+    Bins& bins{ jobBins[job] };
+    bins.triangleCount = 0;
+    for (std::vector<Triangle>& tile : bins.tiles)
+        tile.clear();
+
+    uint64_t begin{ triangleCount * job / jobBins.size() };
+    uint64_t end{ triangleCount * (job + 1) / jobBins.size() };
+    uint64_t drawStart{};
+    for (size_t d = 0; d < drawCount && drawStart < end; d++)
+    {
+        const DrawElementsIndirectCommand& draw{ draws[d] };
+        uint64_t perInstance{ draw.count / 3 };
+        uint64_t total{ perInstance * draw.instanceCount };
+        if (drawStart + total <= begin)
+        {
+            drawStart += total;
+            continue;
+        }
+
+        const GLuint* drawIndices{ indices + (draw.firstIndex - firstIndex) };
+        const glm::vec3* drawPositions{ positions + (draw.baseVertex - firstVertex) };
+        uint64_t to{ std::min(end, drawStart + total) - drawStart };
+        for (uint64_t i = std::max(begin, drawStart) - drawStart; i < to;)
+        {
+            uint64_t instance{ i / perInstance };
+            uint64_t last{ std::min(to - instance * perInstance, perInstance) };
+
+            // Vertex stage: one model view projection per instance, columns in SSE registers
+            glm::mat4 mvp{ viewProjection * models[draw.baseInstance + instance] };
+            glm_vec4 columns[4]{ _mm_loadu_ps(&mvp[0][0]), _mm_loadu_ps(&mvp[1][0]), _mm_loadu_ps(&mvp[2][0]), _mm_loadu_ps(&mvp[3][0]) };
+            for (uint64_t t = i - instance * perInstance; t < last; t++)
+            {
+                glm::vec4 clip[3]{};
+                for (int k = 0; k < 3; k++)
+                {
+                    const glm::vec3& p{ drawPositions[drawIndices[3 * t + k]] };
+                    _mm_storeu_ps(&clip[k][0], glm_mat4_mul_vec4(columns, _mm_setr_ps(p.x, p.y, p.z, 1.0f)));
+                }
+                clipTriangle(clip, color, bins);
+            }
+            i = instance * perInstance + last;
+        }
+        drawStart += total;
+    }
+}
+
+// Rejects triangles outside the view, clips the rest against the near and far planes and the
+// guard band only where they cross them, and sets up what is left as a fan
+void SoftwareRasterizer::clipTriangle(const glm::vec4 (&clip)[3], uint32_t color, Bins& bins) const
+{
+    // Outcodes against the view, then against the clipping planes in planeDistance() order
+    const glm::vec2 band{ 1.0f + 2.0f * guardBand / targetWidth, 1.0f + 2.0f * guardBand / targetHeight };
+    int outside[3]{}, crossed{};
+    for (int k = 0; k < 3; k++)
+    {
+        const glm::vec4& p{ clip[k] };
+        outside[k] = (p.x < -p.w) | (p.x > p.w) << 1 | (p.y < -p.w) << 2 | (p.y > p.w) << 3 | (p.z < -p.w) << 4 | (p.z > p.w) << 5;
+        crossed |= (p.z < -p.w) | (p.z > p.w) << 1 | (p.x < -band.x * p.w) << 2 | (p.x > band.x * p.w) << 3 |
+                   (p.y < -band.y * p.w) << 4 | (p.y > band.y * p.w) << 5;
+    }
+    if (outside[0] & outside[1] & outside[2])
+        return;
+    if (!crossed)
+    {
+        setupTriangle(clip, color, bins);
+        return;
+    }
+
+    // Sutherland-Hodgman: every plane adds at most one vertex
+    glm::vec4 polygon[9]{ clip[0], clip[1], clip[2] }, next[9]{};
+    int count{ 3 };
+    for (int plane = 0; plane < 6 && count >= 3; plane++)
+    {
+        if (!(crossed & 1 << plane))
+            continue;
+        int kept{};
+        for (int k = 0; k < count; k++)
+        {
+            const glm::vec4& from{ polygon[k] };
+            const glm::vec4& to{ polygon[(k + 1) % count] };
+            float d0{ planeDistance(from, plane, band) }, d1{ planeDistance(to, plane, band) };
+            if (d0 >= 0.0f)
+                next[kept++] = from;
+            if ((d0 >= 0.0f) != (d1 >= 0.0f))
+                next[kept++] = glm::mix(from, to, d0 / (d0 - d1));
+        }
+        std::copy(next, next + kept, polygon);
+        count = kept;
+    }
+    for (int k = 1; k + 1 < count; k++)
+    {
+        const glm::vec4 fan[3]{ polygon[0], polygon[k], polygon[k + 1] };
+        setupTriangle(fan, color, bins);
+    }
+}
+
+void SoftwareRasterizer::setupTriangle(const glm::vec4* clip, uint32_t color, Bins& bins) const
+{
+    // Window coordinates, y up like GL; x and y snapped to 1/16 pixel
+    int64_t x[3]{}, y[3]{};
+    float z[3]{};
+    for (int k = 0; k < 3; k++)
+    {
+        float inverseW{ 1.0f / clip[k].w };
+        x[k] = _mm_cvtss_si32(_mm_set_ss((clip[k].x * inverseW * 0.5f + 0.5f) * targetWidth * subpixels));
+        y[k] = _mm_cvtss_si32(_mm_set_ss((clip[k].y * inverseW * 0.5f + 0.5f) * targetHeight * subpixels));
+        z[k] = glm::clamp(clip[k].z * inverseW * 0.5f + 0.5f, 0.0f, 1.0f);
+    }
+    int64_t area{ (x[1] - x[0]) * (y[2] - y[0]) - (y[1] - y[0]) * (x[2] - x[0]) };
+    if (area == 0)
+        return;
+    if (area < 0)
+    {
+        // Both facings are drawn, edges are set up counter-clockwise
+        std::swap(x[1], x[2]);
+        std::swap(y[1], y[2]);
+        std::swap(z[1], z[2]);
+        area = -area;
+    }
+
+    // Pixels whose centers (16 p + 8) can be inside; the shifts round towards -infinity
+    Triangle triangle{};
+    const int half{ subpixels / 2 };
+    triangle.minX = std::max(0, static_cast<int>((std::min({ x[0], x[1], x[2] }) - half + subpixels - 1) >> subpixelBits));
+    triangle.minY = std::max(0, static_cast<int>((std::min({ y[0], y[1], y[2] }) - half + subpixels - 1) >> subpixelBits));
+    triangle.maxX = std::min(targetWidth - 1, static_cast<int>((std::max({ x[0], x[1], x[2] }) - half) >> subpixelBits));
+    triangle.maxY = std::min(targetHeight - 1, static_cast<int>((std::max({ y[0], y[1], y[2] }) - half) >> subpixelBits));
+    if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+        return;
+
+    for (int edge = 0; edge < 3; edge++)
+    {
+        int from{ (edge + 1) % 3 }, to{ (edge + 2) % 3 };
+        int64_t dx{ x[to] - x[from] }, dy{ y[to] - y[from] };
+        triangle.a[edge] = static_cast<int32_t>(-dy);
+        triangle.b[edge] = static_cast<int32_t>(dx);
+        triangle.c[edge] = dy * x[from] - dx * y[from];
+        // Pixel centers on an edge belong to the triangle right of it or above it: the top-left
+        // rule of y down window coordinates, which is what GL rasterizers apply with y up
+        bool owned{ dy < 0 || (dy == 0 && dx > 0) };
+        if (!owned)
+            triangle.c[edge] -= 1;
+    }
+
+    // Depth plane over window coordinates in pixels
+    float fx[3]{}, fy[3]{};
+    for (int k = 0; k < 3; k++)
+    {
+        fx[k] = static_cast<float>(x[k]) / subpixels;
+        fy[k] = static_cast<float>(y[k]) / subpixels;
+    }
+    float inverseArea{ static_cast<float>(subpixels * subpixels) / static_cast<float>(area) };
+    triangle.depthX = ((z[1] - z[0]) * (fy[2] - fy[0]) - (z[2] - z[0]) * (fy[1] - fy[0])) * inverseArea;
+    triangle.depthY = ((fx[1] - fx[0]) * (z[2] - z[0]) - (fx[2] - fx[0]) * (z[1] - z[0])) * inverseArea;
+    triangle.depthC = z[0] - triangle.depthX * fx[0] - triangle.depthY * fy[0];
+    triangle.nearest = std::min({ z[0], z[1], z[2] });
+    triangle.color = color;
+
+    // Binning: every tile of the bounding box no edge rejects as a whole
+    bool binned{};
+    for (int ty = triangle.minY / tileSize; ty <= triangle.maxY / tileSize; ty++)
+    {
+        for (int tx = triangle.minX / tileSize; tx <= triangle.maxX / tileSize; tx++)
+        {
+            bool rejected{};
+            for (int edge = 0; edge < 3 && !rejected; edge++)
+            {
+                int64_t a{ triangle.a[edge] }, b{ triangle.b[edge] };
+                int64_t px{ int64_t(tx * tileSize) * subpixels + half }, py{ int64_t(ty * tileSize) * subpixels + half };
+                int64_t farthest{ a * px + b * py + triangle.c[edge] + std::max<int64_t>(0, a * (tileSize - 1) * subpixels) +
+                                  std::max<int64_t>(0, b * (tileSize - 1) * subpixels) };
+                rejected = farthest < 0;
+            }
+            if (!rejected)
+            {
+                bins.tiles[size_t(ty) * tilesX + tx].push_back(triangle);
+                binned = true;
+            }
+        }
+    }
+    if (binned)
+        bins.triangleCount++;
+}
+
+// Tiles own their pixels, so the raster phase shares nothing but the read-only bins
+void SoftwareRasterizer::rasterizeTile(unsigned tile)
+{
+    int tileX{ static_cast<int>(tile % tilesX) * tileSize };
+    int tileY{ static_cast<int>(tile / tilesX) * tileSize };
+    for (const Bins& bins : jobBins)
+    {
+        for (const Triangle& triangle : bins.tiles[tile])
+        {
+            int x0{ std::max(triangle.minX, tileX) / blockSize }, x1{ std::min(triangle.maxX, tileX + tileSize - 1) / blockSize };
+            int y0{ std::max(triangle.minY, tileY) / blockSize }, y1{ std::min(triangle.maxY, tileY + tileSize - 1) / blockSize };
+            for (int blockY = y0; blockY <= y1; blockY++)
+                for (int blockX = x0; blockX <= x1; blockX++)
+                    rasterizeBlock(triangle, blockX, blockY);
+        }
+    }
+}
+
+void SoftwareRasterizer::rasterizeBlock(const Triangle& triangle, int blockX, int blockY)
+{
+    // Hierarchical depth: nothing of the triangle is nearer than what the block already holds
+    float& farthest{ blockFarthest[size_t(blockY) * (pitch / blockSize) + blockX] };
+    if (triangle.nearest >= farthest)
+        return;
+
+    // Rows of the block the triangle's bounds cover, small triangles skip most of them
+    int px{ blockX * blockSize }, py{ std::max(blockY * blockSize, triangle.minY) };
+    int rows{ std::min(blockY * blockSize + blockSize - 1, triangle.maxY) - py + 1 };
+    const int half{ subpixels / 2 };
+    int32_t rowEdge[3]{};
+    Int8 edgeRamp[3]{};
+    for (int edge = 0; edge < 3; edge++)
+    {
+        int64_t a{ triangle.a[edge] }, b{ triangle.b[edge] };
+        int64_t value{ a * (int64_t(px) * subpixels + half) + b * (int64_t(py) * subpixels + half) + triangle.c[edge] };
+        int64_t reach{ std::max<int64_t>(0, a * (blockSize - 1) * subpixels) + std::max<int64_t>(0, b * (rows - 1) * subpixels) };
+        if (value + reach < 0)
+            return;
+        rowEdge[edge] = static_cast<int32_t>(glm::clamp(value, -edgeLimit, edgeLimit));
+        edgeRamp[edge] = ramp(static_cast<int32_t>(a * subpixels));
+    }
+    const Float8 depthRamp{ ramp(triangle.depthX) };
+    const Float8 color{ splatBits(triangle.color) };
+    float rowDepth{ triangle.depthX * (px + 0.5f) + triangle.depthY * (py + 0.5f) + triangle.depthC };
+
+    bool written{};
+    for (int row = 0; row < rows; row++)
+    {
+        size_t offset{ size_t(py + row) * pitch + px };
+        Int8 w0{ splat(rowEdge[0]) + edgeRamp[0] };
+        Int8 w1{ splat(rowEdge[1]) + edgeRamp[1] };
+        Int8 w2{ splat(rowEdge[2]) + edgeRamp[2] };
+        Float8 depth{ splat(rowDepth) + depthRamp };
+        Float8 stored{ load(&depthBuffer[offset]) };
+        Float8 pass{ nonNegative(w0 | w1 | w2) & less(depth, stored) };
+        if (any(pass))
+        {
+            stored = select(pass, depth, stored);
+            store(&depthBuffer[offset], stored);
+            store(&colorBuffer[offset], select(pass, color, load(&colorBuffer[offset])));
+            written = true;
+        }
+
+        for (int edge = 0; edge < 3; edge++)
+            rowEdge[edge] += triangle.b[edge] * subpixels;
+        rowDepth += triangle.depthY;
+    }
+    if (written)
+    {
+        Float8 blockMax{ load(&depthBuffer[size_t(blockY) * blockSize * pitch + px]) };
+        for (int row = 1; row < blockSize; row++)
+            blockMax = max(blockMax, load(&depthBuffer[(size_t(blockY) * blockSize + row) * pitch + px]));
+        farthest = reduceMax(blockMax);
+    }
+}
+
+void SoftwareRasterizer::parallelFor(unsigned count, const std::function<void(unsigned)>& job)
+{
+    {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        task = &job;
+        taskCount = count;
+        nextTask = 0;
+        busyWorkers = static_cast<unsigned>(workers.size());
+        generation++;
+    }
+    wake.notify_all();
+
+    for (unsigned i = nextTask++; i < count; i = nextTask++)
+        job(i);
+
+    std::unique_lock<std::mutex> lock(poolMutex);
+    finished.wait(lock, [this] { return busyWorkers == 0; });
+    task = nullptr;
+}
+
+void SoftwareRasterizer::workerLoop()
+{
+    uint64_t seen{};
+    for (;;)
+    {
+        const std::function<void(unsigned)>* job{};
+        unsigned count{};
+        {
+            std::unique_lock<std::mutex> lock(poolMutex);
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping)
+                return;
+            seen = generation;
+            job = task;
+            count = taskCount;
+        }
+
+        for (unsigned i = nextTask++; i < count; i = nextTask++)
+            (*job)(i);
+
+        std::lock_guard<std::mutex> lock(poolMutex);
+        if (--busyWorkers == 0)
+            finished.notify_one();
+    }
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <GL/glew.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "DrawBatch.h"
+
+// CPU backend of the scene pass for machines without a GPU. It takes the same indirect draws as
+// DrawBatch::submit() and renders them like the GL path with GL_LESS depth and no face culling.
+// The pipeline has two phases, each spread over a worker pool:
+// - Setup: triangles are transformed, clipped and set up, then binned into 64x64 pixel tiles.
+//   Every job keeps its own bins, so this phase needs no locks.
+// - Raster: each tile walks the bins in submission order. It tests 8 pixels at a time against
+//   the edge functions and skips 8x8 blocks whose farthest depth is already nearer than the
+//   triangle.
+// No GL calls are made; GL types only describe the draws.
+class SoftwareRasterizer
+{
+public:
+    static const int tileSize{ 64 };
+
+    // threadCount 0 uses every hardware thread; false when the target is too large for the
+    // fixed point edge functions (4096 pixels a side)
+    bool init(int width, int height, unsigned threadCount = 0);
+    void shutdown();
+
+    // The streams the vertex array and the instance buffer hold in the GL path: positions as
+    // fetched (fetchPositions()) starting at vertex firstVertex, the index stream starting at
+    // index firstIndex, and the model matrices with the decode folded in. The arrays are not
+    // copied, they have to outlive the draws.
+    void setGeometry(const glm::vec3* positions, GLint firstVertex, const GLuint* indices, GLuint firstIndex, const glm::mat4* models);
+
+    // RGBA8 color, depth in [0, 1]
+    void clear(uint32_t color, float depth = 1.0f);
+
+    // glMultiDrawElementsIndirect of triangles, every fragment written with one color since
+    // Fragment.glsl only reads a texture. Returns the triangles left after clipping.
+    uint64_t draw(const DrawElementsIndirectCommand* draws, size_t drawCount, const glm::mat4& viewProjection, uint32_t color);
+
+    int width() const { return targetWidth; }
+    int height() const { return targetHeight; }
+    unsigned threadCount() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+    // Bottom row first like glReadPixels, width() * height() pixels
+    void readPixels(std::vector<uint32_t>& pixels) const;
+
+private:
+    // A triangle after setup, in 28.4 fixed point window coordinates. Edge i is the one
+    // opposite corner i; E(x, y) = a*x + b*y + c is >= 0 inside, fill rule bias included.
+    struct Triangle
+    {
+        int32_t a[3]{}, b[3]{};
+        int64_t c[3]{};
+        int     minX{}, minY{}, maxX{}, maxY{};     // pixels, inclusive, on the target
+        float   depthX{}, depthY{}, depthC{};       // window depth at pixel centers
+        float   nearest{};
+        uint32_t color{};
+    };
+
+    // What one setup job produced, per tile a copy of every triangle touching it, so the raster
+    // phase streams through memory instead of chasing indices
+    struct Bins
+    {
+        std::vector<std::vector<Triangle>> tiles{};
+        uint64_t triangleCount{};
+    };
+
+    void setupJob(unsigned job, const DrawElementsIndirectCommand* draws, size_t drawCount, uint64_t triangleCount,
+                  const glm::mat4& viewProjection, uint32_t color);
+    void clipTriangle(const glm::vec4 (&clip)[3], uint32_t color, Bins& bins) const;
+    void setupTriangle(const glm::vec4* clip, uint32_t color, Bins& bins) const;
+    void rasterizeTile(unsigned tile);
+    void rasterizeBlock(const Triangle& triangle, int blockX, int blockY);
+
+    // Runs job(0 .. count - 1) on the pool and the calling thread, returns when all are done
+    void parallelFor(unsigned count, const std::function<void(unsigned)>& job);
+    void workerLoop();
+
+    int targetWidth{}, targetHeight{};
+    int pitch{};                                // pixels per row, whole tiles
+    int tilesX{}, tilesY{};
+    std::vector<uint32_t> colorBuffer{};
+    std::vector<float>    depthBuffer{};
+    std::vector<float>    blockFarthest{};      // per 8x8 block, the hierarchical depth test
+    std::vector<Bins>     jobBins{};
+
+    const glm::vec3* positions{};
+    GLint            firstVertex{};
+    const GLuint*    indices{};
+    GLuint           firstIndex{};
+    const glm::mat4* models{};
+
+    std::vector<std::thread> workers{};
+    std::mutex               poolMutex{};
+    std::condition_variable  wake{};
+    std::condition_variable  finished{};
+    const std::function<void(unsigned)>* task{};
+    unsigned                 taskCount{};
+    std::atomic<unsigned>    nextTask{};
+    unsigned                 busyWorkers{};
+    uint64_t                 generation{};
+    bool                     stopping{};
+};
@@ -0,0 +1,306 @@
+#include "Tessellator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace
+{
+    // Segments an edge with this level is cut into, after clamping and rounding
+    int segmentCount(float level, TessellationSpacing spacing, float maxLevel)
+    {
+        switch (spacing)
+        {
+        case TessellationSpacing::FractionalOdd:
+        {
+            int n{ static_cast<int>(std::ceil(glm::clamp(level, 1.0f, maxLevel - 1.0f))) };
+            return n % 2 ? n : n + 1;
+        }
+        case TessellationSpacing::FractionalEven:
+        {
+            int n{ static_cast<int>(std::ceil(glm::clamp(level, 2.0f, maxLevel))) };
+            return n % 2 ? n + 1 : n;
+        }
+        default:
+            return static_cast<int>(std::ceil(glm::clamp(level, 1.0f, maxLevel)));
+        }
+    }
+
+    // One ring as three sides, corner i to corner i + 1; a side of n segments has n + 1
+    // point indices, each corner is shared by the two sides that meet there
+    struct Ring
+    {
+        std::vector<uint32_t> sides[3]{};
+    };
+
+    Ring addRing(TessellatedPatch& patch, const glm::vec3 (&corners)[3], const int (&segments)[3])
+    {
+        Ring ring{};
+        uint32_t first{ static_cast<uint32_t>(patch.coordinates.size()) };
+        for (int side = 0; side < 3; side++)
+        {
+            const glm::vec3& from{ corners[side] };
+            const glm::vec3& to{ corners[(side + 1) % 3] };
+            for (int i = 0; i < segments[side]; i++)
+            {
+                ring.sides[side].push_back(static_cast<uint32_t>(patch.coordinates.size()));
+                patch.coordinates.push_back(glm::mix(from, to, static_cast<float>(i) / segments[side]));
+            }
+        }
+        // Close every side with the first point of the next one
+        for (int side = 0; side < 3; side++)
+            ring.sides[side].push_back(side < 2 ? ring.sides[side + 1].front() : first);
+        return ring;
+    }
+
+    void addTriangle(TessellatedPatch& patch, uint32_t a, uint32_t b, uint32_t c)
+    {
+        patch.triangles.push_back(a);
+        patch.triangles.push_back(b);
+        patch.triangles.push_back(c);
+    }
+
+    // Strip between a ring and the next one inside it, side by side; a side with a and b
+    // segments gives a + b triangles. The inner side may be a single point, the center.
+    void joinRings(TessellatedPatch& patch, const Ring& outer, const Ring& inner)
+    {
+        for (int side = 0; side < 3; side++)
+        {
+            const std::vector<uint32_t>& p{ outer.sides[side] };
+            const std::vector<uint32_t>& q{ inner.sides[side] };
+            size_t a{ p.size() - 1 }, b{ q.size() - 1 }, i{}, j{};
+            while (i < a || j < b)
+            {
+                // Advance along whichever side is behind, compared at segment midpoints
+                if (j == b || (i < a && (2 * i + 1) * b < (2 * j + 1) * a))
+                {
+                    addTriangle(patch, p[i], p[i + 1], q[j]);
+                    i++;
+                }
+                else
+                {
+                    addTriangle(patch, p[i], q[j + 1], q[j]);
+                    j++;
+                }
+            }
+        }
+    }
+}
+
+TessellationLevels patchLevels(const glm::vec4 (&clip)[3], const glm::vec3 (&world)[3], const glm::vec4& camera, float scale,
+                               float maxLevel)
+{
+    TessellationLevels levels{};
+    for (int plane = 0; plane < 6; plane++)
+    {
+        bool outside{ true };
+        for (const glm::vec4& p : clip)
+        {
+            float side{ plane % 2 == 0 ? p.w + p[plane / 2] : p.w - p[plane / 2] };
+            outside = outside && side < 0.0f;
+        }
+        if (outside)
+            return levels;
+    }
+
+    auto edgeLevel = [&](const glm::vec3& a, const glm::vec3& b)
+    {
+        float distance{ camera.w == 0.0f ? 1.0f : std::max(glm::length((a + b) * 0.5f - glm::vec3(camera)), 1e-4f) };
+        return glm::clamp(glm::length(b - a) * scale / distance, 1.0f, maxLevel);
+    };
+    levels.outer[0] = edgeLevel(world[1], world[2]);
+    levels.outer[1] = edgeLevel(world[2], world[0]);
+    levels.outer[2] = edgeLevel(world[0], world[1]);
+    levels.inner = std::max(levels.outer[0], std::max(levels.outer[1], levels.outer[2]));
+    return levels;
+}
+
+size_t tessellateTriangle(const TessellationLevels& levels, TessellationSpacing spacing, TessellatedPatch& patch, float maxLevel)
+{
+    patch.coordinates.clear();
+    patch.triangles.clear();
+    for (float outer : levels.outer)
+        if (!(outer > 0.0f))
+            return 0; // also NaN
+    const glm::vec3 corners[3]{ glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f) };
+
+    // Side i runs from corner i to corner i + 1, the edge opposite corner i + 2
+    int outerSegments[3]{};
+    bool subdivided{};
+    for (int side = 0; side < 3; side++)
+    {
+        outerSegments[side] = segmentCount(levels.outer[(side + 2) % 3], spacing, maxLevel);
+        subdivided = subdivided || outerSegments[side] > 1;
+    }
+    int inner{ segmentCount(levels.inner, spacing, maxLevel) };
+    if (inner == 1 && !subdivided)
+    {
+        patch.coordinates.assign(corners, corners + 3);
+        addTriangle(patch, 0, 1, 2);
+        return 1;
+    }
+    if (inner == 1)
+        inner = spacing == TessellationSpacing::FractionalOdd ? 3 : 2; // 1 + epsilon, rounded
+
+    // Ring k has inner - 2k segments per side. Its corners are where the lines perpendicular
+    // to the outer edges through their k-th subdivision points meet, on the medians.
+    Ring outer{ addRing(patch, corners, outerSegments) };
+    for (int k = 1; inner - 2 * k >= 0; k++)
+    {
+        float t{ static_cast<float>(k) / inner };
+        glm::vec3 ringCorners[3]{};
+        for (int i = 0; i < 3; i++)
+            ringCorners[i] = corners[i] * (1.0f - 2.0f * t) + glm::vec3(2.0f * t / 3.0f);
+
+        int segments{ inner - 2 * k };
+        Ring ring{};
+        if (segments == 0)
+        {
+            // The center, one point all three sides end in
+            uint32_t center{ static_cast<uint32_t>(patch.coordinates.size()) };
+            patch.coordinates.push_back(glm::vec3(1.0f / 3.0f));
+            for (std::vector<uint32_t>& side : ring.sides)
+                side.push_back(center);
+        }
+        else
+        {
+            const int ringSegments[3]{ segments, segments, segments };
+            ring = addRing(patch, ringCorners, ringSegments);
+        }
+        joinRings(patch, outer, ring);
+        if (segments == 1)
+            addTriangle(patch, ring.sides[0][0], ring.sides[1][0], ring.sides[2][0]);
+        outer = ring;
+    }
+    return patch.triangles.size() / 3;
+}
+
+void evaluateTriangle(const TessellatedPatch& patch, const glm::vec3 (&corners)[3], std::vector<glm::vec3>& positions)
+{
+    // Corners as columns, so every point is one matrix times its gl_TessCoord
+    glm::mat3 weights{ corners[0], corners[1], corners[2] };
+    positions.reserve(positions.size() + patch.coordinates.size());
+    for (const glm::vec3& coordinate : patch.coordinates)
+        positions.push_back(weights * coordinate);
+}
+
+void emitPoints(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& triangles, std::vector<glm::vec3>& points)
+{
+    points.reserve(points.size() + triangles.size());
+    for (uint32_t index : triangles)
+        points.push_back(positions[index]);
+}
+
+bool checkTessellator(FILE* log)
+{
+    using Spacing = TessellationSpacing;
+    struct Case
+    {
+        Spacing spacing;
+        float   outer[3];
+        float   inner;
+        size_t  triangles;
+        size_t  points;
+    };
+    // Uniform integer levels n give 3n outer points plus the rings inside. Inner level 1 with a
+    // subdivided outer edge counts as 1 + epsilon: 2 for equal spacing, 3 for fractional odd.
+    // Fractional odd rounds up to odd levels, fractional even clamps to 2 and rounds up to even.
+    const Case cases[]{
+        { Spacing::Equal,          { 1.0f, 1.0f, 1.0f }, 1.0f,  1,  3 },
+        { Spacing::Equal,          { 2.0f, 2.0f, 2.0f }, 2.0f,  6,  7 },
+        { Spacing::Equal,          { 3.0f, 3.0f, 3.0f }, 3.0f, 13, 12 },
+        { Spacing::Equal,          { 4.0f, 4.0f, 4.0f }, 4.0f, 24, 19 },
+        { Spacing::Equal,          { 2.5f, 2.5f, 2.5f }, 2.5f, 13, 12 },
+        { Spacing::Equal,          { 1.0f, 5.0f, 2.0f }, 1.0f,  8,  9 },
+        { Spacing::Equal,          { 0.0f, 4.0f, 4.0f }, 4.0f,  0,  0 },
+        { Spacing::FractionalOdd,  { 1.0f, 1.0f, 1.0f }, 1.0f,  1,  3 },
+        { Spacing::FractionalOdd,  { 2.0f, 2.0f, 2.0f }, 2.0f, 13, 12 },
+        { Spacing::FractionalOdd,  { 3.0f, 3.0f, 3.0f }, 3.0f, 13, 12 },
+        { Spacing::FractionalOdd,  { 4.5f, 4.5f, 4.5f }, 4.5f, 37, 27 },
+        { Spacing::FractionalOdd,  { 1.0f, 5.0f, 2.0f }, 1.0f, 13, 12 },
+        { Spacing::FractionalEven, { 1.0f, 1.0f, 1.0f }, 1.0f,  6,  7 },
+        { Spacing::FractionalEven, { 3.0f, 3.0f, 3.0f }, 3.0f, 24, 19 },
+        { Spacing::FractionalEven, { 4.0f, 4.0f, 4.0f }, 4.0f, 24, 19 },
+        { Spacing::FractionalEven, { 2.0f, 6.0f, 3.0f }, 2.0f, 12, 13 },
+    };
+    const char* names[]{ "equal", "fractional odd", "fractional even" };
+
+    bool passed{ true };
+    TessellatedPatch patch{};
+    for (const Case& test : cases)
+    {
+        TessellationLevels levels{ { test.outer[0], test.outer[1], test.outer[2] }, test.inner };
+        size_t triangles{ tessellateTriangle(levels, test.spacing, patch) };
+        const char* name{ names[static_cast<int>(test.spacing)] };
+        if (triangles != test.triangles || patch.coordinates.size() != test.points)
+        {
+            fprintf(log, "tessellateTriangle: %s %g %g %g / %g gave %zu triangles and %zu points, expected %zu and %zu\n", name,
+                    test.outer[0], test.outer[1], test.outer[2], test.inner, triangles, patch.coordinates.size(), test.triangles, test.points);
+            passed = false;
+        }
+        // Counter-clockwise like the patch: corners 0, 1, 2 map to (1, 0), (0, 1), (0, 0) in (u, v)
+        for (size_t t = 0; t + 2 < patch.triangles.size(); t += 3)
+        {
+            glm::vec2 a{ patch.coordinates[patch.triangles[t]] };
+            glm::vec2 b{ patch.coordinates[patch.triangles[t + 1]] };
+            glm::vec2 c{ patch.coordinates[patch.triangles[t + 2]] };
+            float area{ (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x) };
+            if (!(area > 0.0f))
+            {
+                fprintf(log, "tessellateTriangle: %s %g %g %g / %g has a triangle that is not counter-clockwise\n", name,
+                        test.outer[0], test.outer[1], test.outer[2], test.inner);
+                passed = false;
+                break;
+            }
+        }
+    }
+
+    // Equal spacing positions from the spec: ring k of inner level n has its corners on the
+    // medians, 2k / n of the way from the patch corner to the center
+    struct Position
+    {
+        float  level;
+        glm::vec3 coordinate;
+    };
+    const Position positions[]{
+        { 2.0f, { 1.0f / 3.0f, 1.0f / 3.0f, 1.0f / 3.0f } },
+        { 2.0f, { 0.5f, 0.5f, 0.0f } },
+        { 3.0f, { 5.0f / 9.0f, 2.0f / 9.0f, 2.0f / 9.0f } },
+        { 3.0f, { 2.0f / 9.0f, 5.0f / 9.0f, 2.0f / 9.0f } },
+        { 3.0f, { 2.0f / 9.0f, 2.0f / 9.0f, 5.0f / 9.0f } },
+        { 3.0f, { 2.0f / 3.0f, 1.0f / 3.0f, 0.0f } },
+        { 4.0f, { 2.0f / 3.0f, 1.0f / 6.0f, 1.0f / 6.0f } },
+        { 4.0f, { 5.0f / 12.0f, 5.0f / 12.0f, 1.0f / 6.0f } },
+        { 4.0f, { 1.0f / 3.0f, 1.0f / 3.0f, 1.0f / 3.0f } },
+        { 4.0f, { 0.0f, 0.25f, 0.75f } },
+    };
+    for (const Position& expected : positions)
+    {
+        tessellateTriangle({ { expected.level, expected.level, expected.level }, expected.level }, Spacing::Equal, patch);
+        bool found{ std::any_of(patch.coordinates.begin(), patch.coordinates.end(), [&](const glm::vec3& coordinate)
+                                { return glm::all(glm::lessThan(glm::abs(coordinate - expected.coordinate), glm::vec3(1e-6f))); }) };
+        if (!found)
+        {
+            fprintf(log, "tessellateTriangle: equal %g has no point at (%g, %g, %g)\n", expected.level,
+                    expected.coordinate.x, expected.coordinate.y, expected.coordinate.z);
+            passed = false;
+        }
+    }
+
+    // Levels the fractional modes don't round have to give the equal spacing points
+    const std::pair<Spacing, float> exact[]{ { Spacing::FractionalOdd, 3.0f }, { Spacing::FractionalOdd, 5.0f },
+                                             { Spacing::FractionalEven, 2.0f }, { Spacing::FractionalEven, 4.0f } };
+    TessellatedPatch reference{};
+    for (const std::pair<Spacing, float>& level : exact)
+    {
+        TessellationLevels levels{ { level.second, level.second, level.second }, level.second };
+        tessellateTriangle(levels, Spacing::Equal, reference);
+        tessellateTriangle(levels, level.first, patch);
+        if (patch.coordinates != reference.coordinates || patch.triangles != reference.triangles)
+        {
+            fprintf(log, "tessellateTriangle: %s %g differs from equal spacing\n", names[static_cast<int>(level.first)], level.second);
+            passed = false;
+        }
+    }
+    return passed;
+}
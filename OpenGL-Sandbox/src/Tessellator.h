@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// CPU reference of the tessellation path in res/shaders, so its output can be counted, hashed
+// and timed without a GPU: patchLevels() is TessellationControl.glsl, tessellateTriangle() the
+// fixed function triangle tessellator, evaluateTriangle() TessellationEvaluation.glsl and
+// emitPoints() Geometry.glsl.
+
+// layout(..., *_spacing) of the evaluation stage
+enum class TessellationSpacing { Equal, FractionalOdd, FractionalEven };
+
+struct TessellationLevels
+{
+    float outer[3]{};       // outer[i] is the edge opposite corner i
+    float inner{};
+};
+
+// Domain points and the triangles over them, counter-clockwise like the patch
+struct TessellatedPatch
+{
+    std::vector<glm::vec3> coordinates{};   // gl_TessCoord
+    std::vector<uint32_t>  triangles{};     // 3 per triangle
+};
+
+// Levels of one patch the way TessellationControl.glsl sets them: clip positions for the
+// frustum test, world positions for the edge lengths, camera and scale as in DrawUniforms
+TessellationLevels patchLevels(const glm::vec4 (&clip)[3], const glm::vec3 (&world)[3], const glm::vec4& camera, float scale,
+                               float maxLevel = 64.0f);
+
+// Concentric rings as the GL spec lays them out, the inner level sets how many, the outer
+// levels subdivide the outermost ring's edges. Positions follow the spec exactly for Equal;
+// fractional spacing only rounds the levels the same way and spaces the points evenly, since
+// where the shorter segments go is up to the implementation. Replaces what patch held and
+// returns its triangle count, 0 when an outer level culls the patch.
+size_t tessellateTriangle(const TessellationLevels& levels, TessellationSpacing spacing, TessellatedPatch& patch,
+                          float maxLevel = 64.0f);
+
+// Every point of the patch as its gl_TessCoord weighted corners, appended to positions
+void evaluateTriangle(const TessellatedPatch& patch, const glm::vec3 (&corners)[3], std::vector<glm::vec3>& positions);
+
+// Geometry.glsl: every triangle becomes its three corners as points, appended to points
+void emitPoints(const std::vector<glm::vec3>& positions, const std::vector<uint32_t>& triangles, std::vector<glm::vec3>& points);
+
+// Self-check of tessellateTriangle() against counts and positions worked out by hand from the
+// spec, for all three spacings. Failures go to log; false if any.
+bool checkTessellator(FILE* log);
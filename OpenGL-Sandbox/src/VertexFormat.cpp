@@ -0,0 +1,320 @@
+#include "VertexFormat.h"
+
+#include <GL/glew.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <glm/glm.hpp>
+#include <glm/packing.hpp>
+#include <glm/gtc/packing.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace
+{
+    // Unit vector to the [-1, 1]^2 square: project on the octahedron, fold the lower half out
+    glm::vec2 encodeOctahedral(glm::vec3 n)
+    {
+        n /= std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+        glm::vec2 p{ n.x, n.y };
+        if (n.z < 0.0f)
+        {
+            p = glm::vec2((1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f),
+                          (1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f));
+        }
+        return p;
+    }
+
+    // Vertex.glsl's decodeOctahedral()
+    glm::vec3 decodeOctahedral(glm::vec2 encoded)
+    {
+        glm::vec3 n{ encoded, 1.0f - std::abs(encoded.x) - std::abs(encoded.y) };
+        float fold{ std::max(-n.z, 0.0f) };
+        n.x += n.x >= 0.0f ? -fold : fold;
+        n.y += n.y >= 0.0f ? -fold : fold;
+        return glm::normalize(n);
+    }
+
+    // A zero normal stays zero instead of becoming NaN
+    glm::vec2 octahedralNormal(const float* n)
+    {
+        glm::vec3 normal{ n[0], n[1], n[2] };
+        float length{ glm::length(normal) };
+        return length > 0.0f ? encodeOctahedral(normal / length) : glm::vec2(0.0f);
+    }
+
+    template <typename T>
+    void put(std::vector<char>& data, size_t offset, T value)
+    {
+        memcpy(&data[offset], &value, sizeof(value));
+    }
+
+    // One attribute as the vertex shader sees it, missing components read as GL fills them in
+    glm::vec4 fetchAttribute(const char* vertex, const MeshAttribute& attribute)
+    {
+        glm::vec4 value{ 0.0f, 0.0f, 0.0f, 1.0f };
+        const char* data{ vertex + attribute.offset };
+        for (uint32_t c = 0; c < attribute.components && c < 4; c++)
+        {
+            if (attribute.type == GL_SHORT)
+            {
+                int16_t raw{};
+                memcpy(&raw, data + c * sizeof(raw), sizeof(raw));
+                value[c] = attribute.normalized ? std::max(raw / 32767.0f, -1.0f) : float(raw);
+            }
+            else if (attribute.type == GL_BYTE)
+            {
+                int8_t raw{};
+                memcpy(&raw, data + c * sizeof(raw), sizeof(raw));
+                value[c] = attribute.normalized ? std::max(raw / 127.0f, -1.0f) : float(raw);
+            }
+            else if (attribute.type == GL_HALF_FLOAT)
+            {
+                uint16_t raw{};
+                memcpy(&raw, data + c * sizeof(raw), sizeof(raw));
+                value[c] = glm::unpackHalf1x16(raw);
+            }
+            else
+            {
+                memcpy(&value[c], data + c * sizeof(float), sizeof(float));
+            }
+        }
+        return value;
+    }
+
+    const MeshAttribute* findAttribute(const std::vector<MeshAttribute>& attributes, uint32_t location)
+    {
+        for (const MeshAttribute& attribute : attributes)
+            if (attribute.location == location)
+                return &attribute;
+        return nullptr;
+    }
+}
+
+PackedVertices packVertices(const Mesh& mesh, const VertexStreams& streams, VertexEncoding encoding)
+{
+    PackedVertices packed{};
+    size_t vertexCount{ mesh.vertexCount() };
+    auto source = [&mesh](size_t vertex, int offset) { return &mesh.vertices[vertex * mesh.stride + offset]; };
+
+    if (encoding == VertexEncoding::Float)
+    {
+        // Locations in order, the normal as 2 octahedral floats
+        const int sizes[4]{ 3, 2, 4, 2 };
+        const int offsets[4]{ streams.position, streams.normal, streams.tangent, streams.texcoord };
+        uint32_t at[4]{};
+        for (uint32_t location = 0; location < 4; location++)
+        {
+            if (offsets[location] < 0)
+                continue;
+            at[location] = packed.stride;
+            packed.attributes.push_back({ location, uint32_t(sizes[location]), GL_FLOAT, GL_FALSE, at[location] });
+            packed.stride += sizes[location] * sizeof(float);
+        }
+        packed.data.resize(vertexCount * packed.stride);
+        for (size_t v = 0; v < vertexCount; v++)
+        {
+            for (uint32_t location = 0; location < 4; location++)
+            {
+                if (offsets[location] < 0)
+                    continue;
+                char* target{ &packed.data[v * packed.stride + at[location]] };
+                if (location == 1)
+                    memcpy(target, glm::value_ptr(octahedralNormal(source(v, offsets[location]))), 2 * sizeof(float));
+                else
+                    memcpy(target, source(v, offsets[location]), sizes[location] * sizeof(float));
+            }
+        }
+        return packed;
+    }
+
+    // Layout in declaration order, every attribute 4-byte aligned
+    uint32_t positionAt{}, normalAt{}, tangentAt{}, texcoordAt{};
+    uint32_t stride{};
+    if (streams.position >= 0)
+    {
+        positionAt = stride;
+        packed.attributes.push_back({ 0, 3, GL_SHORT, GL_TRUE, positionAt });
+        stride += 4 * sizeof(int16_t); // w is padding, the shader gets 1
+    }
+    if (streams.normal >= 0)
+    {
+        normalAt = stride;
+        packed.attributes.push_back({ 1, 2, GL_SHORT, GL_TRUE, normalAt });
+        stride += 2 * sizeof(int16_t);
+    }
+    if (streams.tangent >= 0)
+    {
+        tangentAt = stride;
+        packed.attributes.push_back({ 2, 4, GL_BYTE, GL_TRUE, tangentAt });
+        stride += 4 * sizeof(int8_t);
+    }
+    if (streams.texcoord >= 0)
+    {
+        texcoordAt = stride;
+        packed.attributes.push_back({ 3, 2, GL_HALF_FLOAT, GL_FALSE, texcoordAt });
+        stride += 2 * sizeof(uint16_t);
+    }
+    packed.stride = stride;
+    packed.data.resize(vertexCount * stride, 0);
+
+    // Positions map the bounding box onto [-1, 1]; a flat axis keeps scale 1 to avoid dividing by 0
+    glm::vec3 low{ 0.0f }, high{ 0.0f };
+    for (size_t v = 0; v < vertexCount && streams.position >= 0; v++)
+    {
+        const float* p{ source(v, streams.position) };
+        low = v ? glm::min(low, glm::vec3(p[0], p[1], p[2])) : glm::vec3(p[0], p[1], p[2]);
+        high = v ? glm::max(high, glm::vec3(p[0], p[1], p[2])) : glm::vec3(p[0], p[1], p[2]);
+    }
+    glm::vec3 center{ (low + high) * 0.5f };
+    glm::vec3 extent{ (high - low) * 0.5f };
+    for (int i = 0; i < 3; i++)
+    {
+        if (extent[i] <= 0.0f)
+            extent[i] = 1.0f;
+        packed.positionOffset[i] = center[i];
+        packed.positionScale[i] = extent[i];
+    }
+
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        size_t base{ v * stride };
+        if (streams.position >= 0)
+        {
+            const float* p{ source(v, streams.position) };
+            glm::vec3 unit{ (glm::vec3(p[0], p[1], p[2]) - center) / extent };
+            for (int i = 0; i < 3; i++)
+                put(packed.data, base + positionAt + i * sizeof(int16_t), glm::packSnorm1x16(unit[i]));
+        }
+        if (streams.normal >= 0)
+        {
+            put(packed.data, base + normalAt, glm::packSnorm2x16(octahedralNormal(source(v, streams.normal))));
+        }
+        if (streams.tangent >= 0)
+        {
+            const float* t{ source(v, streams.tangent) };
+            put(packed.data, base + tangentAt, glm::packSnorm4x8(glm::vec4(t[0], t[1], t[2], t[3])));
+        }
+        if (streams.texcoord >= 0)
+        {
+            const float* uv{ source(v, streams.texcoord) };
+            put(packed.data, base + texcoordAt, glm::packHalf2x16(glm::vec2(uv[0], uv[1])));
+        }
+    }
+    return packed;
+}
+
+std::vector<glm::vec3> fetchPositions(const MeshFile& mesh)
+{
+    const MeshFileHeader& header{ mesh.header() };
+    std::vector<glm::vec3> positions{};
+    std::vector<MeshAttribute> attributes(mesh.attributes(), mesh.attributes() + header.attributeCount);
+    const MeshAttribute* position{ findAttribute(attributes, 0) };
+    if (!position)
+        return positions;
+
+    positions.resize(header.vertexCount);
+    for (uint32_t v = 0; v < header.vertexCount; v++)
+        positions[v] = glm::vec3(fetchAttribute(mesh.vertexData() + size_t(v) * header.vertexStride, *position));
+    return positions;
+}
+
+bool fetchIndices(const MeshFile& mesh, std::vector<uint32_t>& indices)
+{
+    const MeshFileHeader& header{ mesh.header() };
+    indices.resize(header.indexCount);
+    if (header.indexType == GL_UNSIGNED_INT)
+    {
+        memcpy(indices.data(), mesh.indexData(), indices.size() * sizeof(uint32_t));
+    }
+    else
+    {
+        const uint16_t* narrow{ reinterpret_cast<const uint16_t*>(mesh.indexData()) };
+        for (size_t i = 0; i < indices.size(); i++)
+            indices[i] = narrow[i];
+    }
+    for (uint32_t index : indices)
+    {
+        if (index >= header.vertexCount)
+        {
+            indices.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool checkVertexEncodings(FILE* log)
+{
+    // UV sphere off the origin: position, normal, texcoord
+    const int rings{ 16 }, segments{ 32 };
+    const glm::vec3 center{ 3.0f, -1.0f, 0.5f };
+    const float radius{ 2.0f };
+    Mesh sphere{};
+    sphere.stride = 8;
+    for (int ring = 0; ring <= rings; ring++)
+    {
+        for (int segment = 0; segment <= segments; segment++)
+        {
+            float theta{ 3.14159265f * ring / rings }, phi{ 6.28318531f * segment / segments };
+            glm::vec3 normal{ std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) };
+            glm::vec3 position{ center + radius * normal };
+            float uv[2]{ float(segment) / segments, float(ring) / rings };
+            sphere.vertices.insert(sphere.vertices.end(), { position.x, position.y, position.z, normal.x, normal.y, normal.z, uv[0], uv[1] });
+        }
+    }
+    VertexStreams streams{};
+    streams.normal = 3;
+    streams.texcoord = 6;
+    PackedVertices floats{ packVertices(sphere, streams, VertexEncoding::Float) };
+    PackedVertices quantized{ packVertices(sphere, streams, VertexEncoding::Quantized) };
+
+    // Largest difference the quantized side may add: a snorm16 step of the bounds for
+    // positions, the octahedral snorm16 grid for normals, half precision for texcoords
+    const float tolerance[4]{ radius / 32767.0f + 1e-5f, 1e-3f, 0.0f, 1e-3f };
+    bool passed{ true };
+    for (uint32_t location = 0; location < 4; location++)
+    {
+        const MeshAttribute* a{ findAttribute(floats.attributes, location) };
+        const MeshAttribute* b{ findAttribute(quantized.attributes, location) };
+        if (!a && !b)
+            continue;
+        if (!a || !b || a->components != b->components)
+        {
+            fprintf(log, "packVertices: location %u differs between the float and quantized layouts\n", location);
+            passed = false;
+            continue;
+        }
+
+        float worst{};
+        for (size_t v = 0; v < sphere.vertexCount(); v++)
+        {
+            glm::vec4 x{ fetchAttribute(&floats.data[v * floats.stride], *a) };
+            glm::vec4 y{ fetchAttribute(&quantized.data[v * quantized.stride], *b) };
+            // What the shader ends up with: decoded positions and unfolded normals
+            if (location == 0)
+            {
+                for (int c = 0; c < 3; c++)
+                {
+                    x[c] = floats.positionOffset[c] + x[c] * floats.positionScale[c];
+                    y[c] = quantized.positionOffset[c] + y[c] * quantized.positionScale[c];
+                }
+            }
+            else if (location == 1)
+            {
+                x = glm::vec4(decodeOctahedral(glm::vec2(x)), 0.0f);
+                y = glm::vec4(decodeOctahedral(glm::vec2(y)), 0.0f);
+            }
+            glm::vec4 difference{ glm::abs(x - y) };
+            worst = std::max(worst, std::max(std::max(difference.x, difference.y), std::max(difference.z, difference.w)));
+        }
+        if (worst > tolerance[location])
+        {
+            fprintf(log, "packVertices: location %u differs by %g between the float and quantized layouts, expected at most %g\n",
+                    location, worst, tolerance[location]);
+            passed = false;
+        }
+    }
+    return passed;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "MeshBuilder.h"
+#include "MeshFile.h"
+
+// Where each attribute sits in a Mesh vertex, in floats; -1 if the mesh doesn't have it.
+// Attribute locations are fixed: position 0, normal 1, tangent 2, texcoord 3.
+struct VertexStreams
+{
+    int position{ 0 };
+    int normal{ -1 };
+    int tangent{ -1 };      // xyz + handedness in w
+    int texcoord{ -1 };
+};
+
+// Float keeps 32-bit floats, except that the normal is octahedral like below since Vertex.glsl
+// takes a vec2 at location 1 either way. Quantized stores:
+//  - position as normalized int16 relative to the mesh bounds (8 bytes),
+//  - normal as octahedral snorm16x2 (4 bytes),
+//  - tangent as snorm8x4 (4 bytes),
+//  - texcoord as half2 (4 bytes).
+// GL turns all of these back into floats when it fetches them. positionOffset/positionScale
+// ride along in the instance transform (MeshRange::decode), the shader only decodes the
+// octahedral normal (res/shaders/VertexFormat.glsl).
+enum class VertexEncoding { Float, Quantized };
+
+struct PackedVertices
+{
+    std::vector<char>           data{};
+    uint32_t                    stride{};               // bytes
+    std::vector<MeshAttribute>  attributes{};
+    float                       positionOffset[3]{};    // position = offset + fetched * scale
+    float                       positionScale[3]{ 1.0f, 1.0f, 1.0f };
+};
+
+PackedVertices packVertices(const Mesh& mesh, const VertexStreams& streams = {}, VertexEncoding encoding = VertexEncoding::Quantized);
+
+// Streams of a mesh file as the GPU fetches them, for CPU references of the pipeline: positions
+// (location 0) with normalized integers turned into floats, the decode stays in MeshRange::decode,
+// and the whole index stream widened to 32 bits like MeshPool stores it. MeshFile only checks
+// the tables, so the indices are checked here: false, indices left empty, when one is past
+// the vertices. CPU code indexes positions with nothing else.
+std::vector<glm::vec3> fetchPositions(const MeshFile& mesh);
+bool fetchIndices(const MeshFile& mesh, std::vector<uint32_t>& indices);
+
+// Self-check: a sphere packed both ways has to reach the vertex shader as the same attributes,
+// component counts equal and values within the quantization steps, so both draw the same
+// image. Failures go to log; false if any.
+bool checkVertexEncodings(FILE* log);
@@ -0,0 +1,222 @@
+// Offline half of the shader pipeline: expands every stage of the default program for
+// every variant in res/shaders/Variants.txt, and every standalone compute pass, validates
+// them with glslangValidator and packs source and SPIR-V into one archive for
+// OpenGL-Sandbox --shader-archive.
+//
+// Usage: ShaderBaker [--root <OpenGL-Sandbox dir>] [--out <file.pak>] [--glslang <exe>] [--no-validate]
+
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "Shader.h"
+#include "ShaderArchive.h"
+#include "ShaderPreprocessor.h"
+
+namespace fs = std::filesystem;
+
+struct BakeOptions
+{
+    std::string root{ "." };                     // relative paths below start here
+    std::string output{ "res/shaders.pak" };
+    std::string compiler{ "glslangValidator" };
+    bool        validate{ true };                // --no-validate: pack text only, no SPIR-V
+};
+
+static const char* stageName(GLenum type)
+{
+    switch (type)
+    {
+    case GL_VERTEX_SHADER:          return "vert";
+    case GL_TESS_CONTROL_SHADER:    return "tesc";
+    case GL_TESS_EVALUATION_SHADER: return "tese";
+    case GL_GEOMETRY_SHADER:        return "geom";
+    case GL_FRAGMENT_SHADER:        return "frag";
+    case GL_COMPUTE_SHADER:         return "comp";
+    }
+    return "";
+}
+
+static bool readFile(const fs::path& path, std::string& out)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+    out.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+static bool writeFile(const fs::path& path, const std::string& text)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << text;
+    return static_cast<bool>(file);
+}
+
+// Bakers running side by side (parallel builds, several checkouts) share the temp
+// directory, so the scratch files carry the process id
+static fs::path tempPath(const char* extension)
+{
+#ifdef _WIN32
+    int pid{ _getpid() };
+#else
+    int pid{ static_cast<int>(getpid()) };
+#endif
+    return fs::temp_directory_path() / ("ShaderBaker-" + std::to_string(pid) + extension);
+}
+
+// Runs the reference compiler on the expanded text; log gets its error list on failure.
+static bool validateStage(const BakeOptions& options, GLenum type, const std::string& source,
+                          std::vector<char>& spirv, std::string& log)
+{
+    fs::path input{ tempPath(".glsl") };
+    fs::path output{ tempPath(".spv") };
+    fs::path logPath{ tempPath(".log") };
+    if (!writeFile(input, source))
+    {
+        log = "Can't write " + input.string();
+        return false;
+    }
+
+    // -G: SPIR-V for OpenGL, locations/bindings the GLSL leaves implicit are assigned
+    std::string command{ "\"" + options.compiler + "\" -G --aml --amb -S " + stageName(type) +
+                         " -o \"" + output.string() + "\" \"" + input.string() + "\" > \"" + logPath.string() + "\" 2>&1" };
+#ifdef _WIN32
+    command = "\"" + command + "\""; // cmd /c strips the outer pair
+#endif
+    std::error_code ignored{};
+    fs::remove(output, ignored);
+    int status{ std::system(command.c_str()) };
+
+    readFile(logPath, log);
+    std::string binary{};
+    bool compiled{ status == 0 && readFile(output, binary) && !binary.empty() };
+    fs::remove(input, ignored);
+    fs::remove(output, ignored);
+    fs::remove(logPath, ignored);
+    if (!compiled)
+        return false;
+    spirv.assign(binary.begin(), binary.end());
+    return true;
+}
+
+static BakeOptions parseArguments(int argc, char** argv)
+{
+    BakeOptions options{};
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg{ argv[i] };
+        if (arg == "--root" && i + 1 < argc)
+            options.root = argv[++i];
+        else if (arg == "--out" && i + 1 < argc)
+            options.output = argv[++i];
+        else if (arg == "--glslang" && i + 1 < argc)
+            options.compiler = argv[++i];
+        else if (arg == "--no-validate")
+            options.validate = false;
+        else
+            fprintf(stderr, "Unknown argument: %s\n", argv[i]);
+    }
+    return options;
+}
+
+int main(int argc, char** argv)
+{
+    BakeOptions options{ parseArguments(argc, argv) };
+    std::error_code error{};
+    fs::current_path(options.root, error);
+    if (error || !fs::is_directory("res/shaders"))
+    {
+        fprintf(stderr, "No res/shaders under %s\n", options.root.c_str());
+        return 1;
+    }
+
+    std::vector<std::vector<std::string>> variants{ readVariantList() };
+    ShaderPreprocessor preprocessor{};
+    ShaderArchiveWriter writer{};
+    std::set<std::string> reached{};
+    int stages{}, failures{};
+
+    std::set<uint64_t> baked{};
+    auto bakeStage = [&](const Shader& stage, const std::vector<std::string>& defines)
+    {
+        uint64_t key{ ShaderArchive::stageKey(stage.path, defines) };
+        if (isSpirvPath(stage.path) || !baked.insert(key).second)
+            return; // already compiled offline, or shared with another program
+
+        std::string name{ stage.path };
+        for (const std::string& define : defines)
+            name += " " + define;
+
+        ShaderSource source{};
+        if (!preprocessor.process(stage.path, source, defines))
+        {
+            fprintf(stderr, "%s: can't preprocess\n", name.c_str());
+            failures++;
+            return;
+        }
+        reached.insert(source.files.begin(), source.files.end());
+
+        std::string text{ source.text() };
+        std::vector<char> spirv{};
+        std::string log{};
+        if (options.validate && !validateStage(options, stage.type, text, spirv, log))
+        {
+            fprintf(stderr, "%s: validation failed\n%s\n", name.c_str(), log.c_str());
+            failures++;
+            return;
+        }
+        writer.add(key, stage.type, text, spirv, source.files);
+        stages++;
+    };
+
+    // Every stage is baked for every variant, disabled ones included, so all files get validated
+    for (const std::vector<std::string>& defines : variants)
+    {
+        ProgramDesc desc{ defaultProgram() };
+        desc.defines = defines;
+        for (const Shader& stage : desc.pipeline)
+            bakeStage(stage, defines);
+    }
+
+    // Compute passes run standalone, without variants
+    for (const std::string& path : computePasses())
+    {
+        ProgramDesc desc{ computeProgram(path) };
+        for (const Shader& stage : desc.pipeline)
+            if (stage.enabled)
+                bakeStage(stage, {});
+    }
+
+    // A file no stage includes is dead or missing from the program table
+    for (const fs::directory_entry& entry : fs::recursive_directory_iterator("res/shaders"))
+    {
+        std::string path{ normalizePath(entry.path().generic_string()) };
+        if (entry.is_regular_file() && entry.path().extension() == ".glsl" && !reached.count(path))
+            fprintf(stderr, "warning: %s is not used by any baked stage\n", path.c_str());
+    }
+
+    if (failures)
+    {
+        fprintf(stderr, "%d stage(s) failed, %s not written\n", failures, options.output.c_str());
+        return 1;
+    }
+    if (!writer.write(options.output))
+    {
+        fprintf(stderr, "Can't write %s\n", options.output.c_str());
+        return 1;
+    }
+    printf("Baked %d stages (%zu variants) into %s\n", stages, variants.size(), options.output.c_str());
+    return 0;
+}